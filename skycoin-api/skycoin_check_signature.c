@@ -72,6 +72,184 @@ int verify_digest_recover(const ecdsa_curve *curve, uint8_t *pub_key, const uint
 	return 0;
 }
 
+// reads the digest the way verify_digest_recover does, trailing zero bytes are dropped
+static int read_digest(const uint8_t *digest, const bignum256 *order, bignum256 *e)
+{
+	bn_read_be(digest, e);
+	if (bn_is_zero(e)) {
+		return 1;
+	}
+	while (! (uint8_t)e->val[0])
+	{
+		for (int i = 0; i < 8; ++i)
+		{
+			bn_rshift(e);
+		}
+	}
+	bn_fast_mod(e, order);
+	bn_mod(e, order);
+	return 0;
+}
+
+// k = sum_{i=0..63} digits[i] 16^i (mod order) with odd digits, see mpoint_multiply
+static void recode_scalar(const bignum256 *k, const bignum256 *order, int8_t *digits)
+{
+	bignum256 a;
+	uint32_t is_even = (k->val[0] & 1) - 1;
+	uint32_t tmp = 1;
+	int j;
+	for (j = 0; j < 8; j++) {
+		tmp += 0x3fffffff + k->val[j] - (order->val[j] & is_even);
+		a.val[j] = tmp & 0x3fffffff;
+		tmp >>= 30;
+	}
+	a.val[j] = tmp + 0xffff + k->val[j] - (order->val[j] & is_even);
+
+	for (int i = 0; i < 64; i++) {
+		const int shift = (4 * i) % 30;
+		uint32_t bits = a.val[4 * i / 30] >> shift;
+		if (shift > 25) {
+			bits |= a.val[4 * i / 30 + 1] << (30 - shift);
+		}
+		// bit 4 is the sign, bits 1..3 the odd magnitude
+		if (bits & 16) {
+			digits[i] = (int8_t)((bits & 15) | 1);
+		} else {
+			digits[i] = -(int8_t)((~bits & 15) | 1);
+		}
+	}
+}
+
+static void table_point(const curve_point *table, int8_t digit, const bignum256 *prime, curve_point *p)
+{
+	*p = table[(digit < 0 ? -digit : digit) >> 1];
+	if (digit < 0) {
+		bn_subtract(prime, &p->y, &p->y);
+	}
+}
+
+// res = k1 * P1 + k2 * P2 sharing the doublings, tables as from mpoint_odd_multiples
+static int mpoint_multiply_pair(const ecdsa_curve *curve, const bignum256 *k1, const curve_point *table1, const bignum256 *k2, const curve_point *table2, curve_point *res)
+{
+	int8_t digits1[64], digits2[64];
+	jacobian_curve_point jres;
+	curve_point p;
+
+	recode_scalar(k1, &curve->order, digits1);
+	recode_scalar(k2, &curve->order, digits2);
+
+	table_point(table1, digits1[63], &curve->prime, &p);
+	mcurve_to_jacobian(&p, &jres, &curve->prime);
+	table_point(table2, digits2[63], &curve->prime, &p);
+	mpoint_jacobian_add(&p, &jres, curve);
+	for (int i = 62; i >= 0; i--) {
+		mpoint_jacobian_double(&jres, curve);
+		mpoint_jacobian_double(&jres, curve);
+		mpoint_jacobian_double(&jres, curve);
+		mpoint_jacobian_double(&jres, curve);
+		table_point(table1, digits1[i], &curve->prime, &p);
+		mpoint_jacobian_add(&p, &jres, curve);
+		table_point(table2, digits2[i], &curve->prime, &p);
+		mpoint_jacobian_add(&p, &jres, curve);
+	}
+
+	// the additions do not handle equal points or infinity, both leave z = 0
+	bn_mod(&jres.z, &curve->prime);
+	if (bn_is_zero(&jres.z)) {
+		return 1;
+	}
+	mjacobian_to_curve(&jres, res, &curve->prime);
+	return 0;
+}
+
+/* Verifies count signatures of the same digest against known public keys,
+ * without recovering them: R = (e * G + r * Q) / s must have x = r.
+ * gtable and qtables[i] hold the odd multiples of G and of the public keys,
+ * see mpoint_odd_multiples, so that fixed keys can use precomputed tables.
+ * The inverses of the s values share one inversion.
+ * returns 0 if all signatures verify
+ */
+int verify_digest_tables(const ecdsa_curve *curve, const curve_point *gtable, const curve_point *const *qtables, const uint8_t *const *sigs, int count, const uint8_t *digest)
+{
+	bignum256 e, inv, u1, u2;
+	bignum256 r[VERIFY_BATCH_MAX], s[VERIFY_BATCH_MAX], prefix[VERIFY_BATCH_MAX];
+	curve_point R;
+
+	if (count < 1 || count > VERIFY_BATCH_MAX || read_digest(digest, &curve->order, &e)) {
+		return 1;
+	}
+	for (int i = 0; i < count; i++) {
+		bn_read_be(sigs[i], &r[i]);
+		bn_read_be(sigs[i] + 32, &s[i]);
+		if (!bn_is_less(&r[i], &curve->order) || bn_is_zero(&r[i])) {
+			return 1;
+		}
+		if (!bn_is_less(&s[i], &curve->order) || bn_is_zero(&s[i])) {
+			return 1;
+		}
+		// prefix[i] = s[0] * ... * s[i]
+		bn_copy(&s[i], &prefix[i]);
+		if (i > 0) {
+			bn_multiply(&prefix[i - 1], &prefix[i], &curve->order);
+			bn_mod(&prefix[i], &curve->order);
+		}
+	}
+	bn_copy(&prefix[count - 1], &inv);
+	bn_inverse(&inv, &curve->order);
+
+	for (int i = count - 1; i >= 0; i--) {
+		// u2 = s[i]^-1, inv = (s[0] * ... * s[i-1])^-1
+		bn_copy(&inv, &u2);
+		if (i > 0) {
+			bn_multiply(&prefix[i - 1], &u2, &curve->order);
+			bn_multiply(&s[i], &inv, &curve->order);
+		}
+		bn_copy(&u2, &u1);
+		bn_multiply(&e, &u1, &curve->order);
+		bn_mod(&u1, &curve->order);
+		bn_multiply(&r[i], &u2, &curve->order);
+		bn_mod(&u2, &curve->order);
+
+		if (mpoint_multiply_pair(curve, &u1, gtable, &u2, qtables[i], &R)) {
+			return 1;
+		}
+		bn_mod(&R.x, &curve->order);
+		if (!bn_is_equal(&R.x, &r[i])) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* verify_digest_tables for compressed public keys, building the tables
+ * returns 0 if all signatures verify
+ */
+int verify_digest_pubkeys(const uint8_t *const *pubkeys, const uint8_t *const *sigs, int count, const uint8_t *digest)
+{
+	const ecdsa_curve *curve = &msecp256k1;
+	curve_point gtable[8], tables[VERIFY_BATCH_MAX][8];
+	const curve_point *qtables[VERIFY_BATCH_MAX];
+	curve_point q;
+
+	if (count < 1 || count > VERIFY_BATCH_MAX) {
+		return 1;
+	}
+	mpoint_odd_multiples(curve, &curve->G, gtable);
+	for (int i = 0; i < count; i++) {
+		if (pubkeys[i][0] != 0x02 && pubkeys[i][0] != 0x03) {
+			return 1;
+		}
+		bn_read_be(pubkeys[i] + 1, &q.x);
+		uncompress_mcoords(curve, pubkeys[i][0] & 1, &q.x, &q.y);
+		if (!mecdsa_validate_pubkey(curve, &q)) {
+			return 1;
+		}
+		mpoint_odd_multiples(curve, &q, tables[i]);
+		qtables[i] = tables[i];
+	}
+	return verify_digest_tables(curve, gtable, qtables, sigs, count, digest);
+}
+
 /*signature: 65 bytes, 
 message 32 bytes, 
 pubkey 33 bytes
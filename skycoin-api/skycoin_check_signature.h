@@ -6,4 +6,8 @@
 
 int recover_pubkey_from_signed_message(const char* message, const uint8_t* signature, uint8_t* pubkey);
 
+#define VERIFY_BATCH_MAX 3
+
+int verify_digest_pubkeys(const uint8_t *const *pubkeys, const uint8_t *const *sigs, int count, const uint8_t *digest);
+
 #endif
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include "memzero.h"
 #include "hmac.h"
 #include "rand.h"
+#include "opcount.h"
 // #include "secp256k1.h"
 
 
@@ -234,16 +235,7 @@ void mpoint_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_p
 	//
 	// We compute |a[i]| * p in advance for all possible
 	// values of |a[i]| * p.  pmult[i] = (2*i+1) * p
-	// We compute p, 3*p, ..., 15*p and store it in the table pmult.
-	// store p^2 temporarily in pmult[7]
-	pmult[7] = *p;
-	mpoint_double(curve, &pmult[7]);
-	// compute 3*p, etc by repeatedly adding p^2.
-	pmult[0] = *p;
-	for (i = 1; i < 8; i++) {
-		pmult[i] = pmult[7];
-		mpoint_add(curve, &pmult[i-1], &pmult[i]);
-	}
+	mpoint_odd_multiples(curve, p, pmult);
 
 	// now compute  res = sum_{i=0..63} a[i] * 16^i * p step by step,
 	// starting with i = 63.
@@ -301,6 +293,21 @@ void mpoint_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_p
 	memzero(&jres, sizeof(jres));
 }
 
+// table[i] = (2*i+1) * p for i = 0..7
+void mpoint_odd_multiples(const ecdsa_curve *curve, const curve_point *p, curve_point *table)
+{
+	int i;
+	// store p^2 temporarily in table[7]
+	table[7] = *p;
+	mpoint_double(curve, &table[7]);
+	// compute 3*p, etc by repeatedly adding p^2.
+	table[0] = *p;
+	for (i = 1; i < 8; i++) {
+		table[i] = table[7];
+		mpoint_add(curve, &table[i-1], &table[i]);
+	}
+}
+
 void mscalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *res)
 {
 	mpoint_multiply(curve, k, &curve->G, res);
@@ -326,6 +333,7 @@ int mpoint_is_infinity(const curve_point *p)
 void mpoint_add(const ecdsa_curve *curve, const curve_point *cp1, curve_point *cp2)
 {
 	bignum256 lambda, inv, xr, yr;
+	OPCOUNT(point_add);
 
 	if (mpoint_is_infinity(cp1)) {
 		return;
@@ -404,6 +412,7 @@ int mpoint_is_negative_of(const curve_point *p, const curve_point *q)
 void mpoint_double(const ecdsa_curve *curve, curve_point *cp)
 {
 	bignum256 lambda, xr, yr;
+	OPCOUNT(point_double);
 
 	if (mpoint_is_infinity(cp)) {
 		return;
@@ -483,6 +492,7 @@ void mpoint_jacobian_add(const curve_point *p1, jacobian_curve_point *p2, const
 	int is_doubling;
 	const bignum256 *prime = &curve->prime;
 	int a = curve->a;
+	OPCOUNT(point_add);
 
 	assert (-3 <= a && a <= 0);
 
@@ -616,6 +626,7 @@ void mconditional_negate(uint32_t cond, bignum256 *a, const bignum256 *prime)
 void mpoint_jacobian_double(jacobian_curve_point *p, const ecdsa_curve *curve) {
 	bignum256 az4, m, msq, ysq, xysq;
 	const bignum256 *prime = &curve->prime;
+	OPCOUNT(point_double);
 
 	assert (-3 <= curve->a && curve->a <= 0);
 	/* usual algorithm:
@@ -65,9 +65,12 @@ void ecdsa_get_public_key33(const ecdsa_curve *curve, const uint8_t *priv_key, u
 // const curve_info *get_curve_by_name(const char *curve_name);
 // int hdnode_from_seed(const uint8_t *seed, int seed_len, const char* curve, HDNode *out);
 // void hdnode_fill_public_key(HDNode *node);
+extern const ecdsa_curve msecp256k1;
+
 void create_node(const char* seed_str, HNode* node);
 void uncompress_mcoords(const ecdsa_curve *curve, uint8_t odd, const bignum256 *x, bignum256 *y);
 int mecdsa_validate_pubkey(const ecdsa_curve *curve, const curve_point *pub);
+void mpoint_odd_multiples(const ecdsa_curve *curve, const curve_point *p, curve_point *table);
 void mpoint_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_point *p, curve_point *res);
 void mscalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *res);
 void mpoint_set_infinity(curve_point *p);
@@ -83,4 +86,6 @@ void mpoint_jacobian_add(const curve_point *p1, jacobian_curve_point *p2, const
 void mconditional_negate(uint32_t cond, bignum256 *a, const bignum256 *prime);
 void mpoint_jacobian_double(jacobian_curve_point *p, const ecdsa_curve *curve);
 
+int verify_digest_tables(const ecdsa_curve *curve, const curve_point *gtable, const curve_point *const *qtables, const uint8_t *const *sigs, int count, const uint8_t *digest);
+
 #endif
\ No newline at end of file
@@ -9,6 +9,7 @@
 #include "ripemd160.h"
 #include "base58.h"
 #include "ecdsa.h"
+#include "perf_span.h"
 
 extern void bn_print(const bignum256 *a);
 static void create_node(const char* seed_str, HDNode* node);
@@ -91,6 +92,7 @@ void secp256k1Hash(const uint8_t* seed, const size_t seed_length, uint8_t* secp2
     uint8_t hash2[SHA256_DIGEST_LENGTH] = {0};
     uint8_t ecdh_key[33] = {0};
     uint8_t secp256k1Hash[SHA256_DIGEST_LENGTH + 33] = {0};
+    perf_span_begin(PERF_SPAN_SECP256K1_HASH);
     compute_sha256sum(seed, hash, seed_length);
     compute_sha256sum(hash, seckey, sizeof(hash));
     compute_sha256sum(hash, hash2, sizeof(hash));
@@ -99,6 +101,7 @@ void secp256k1Hash(const uint8_t* seed, const size_t seed_length, uint8_t* secp2
     memcpy(secp256k1Hash, hash, sizeof(hash));
     memcpy(&secp256k1Hash[SHA256_DIGEST_LENGTH], ecdh_key, sizeof(ecdh_key));
     compute_sha256sum(secp256k1Hash, secp256k1Hash_digest, sizeof(secp256k1Hash));
+    perf_span_end(PERF_SPAN_SECP256K1_HASH);
 }
 
 // nextSeed should be 32 bytes (size of a secp256k1Hash digest)
@@ -7,6 +7,8 @@
 #include "tools/base58.h"
 #include "tools/ecdsa.h"
 #include "tools/secp256k1.h"
+#include "tools/opcount.h"
+#include "trezor-tools/bip39.h"
 #include "check_digest.h"
 #include "skycoin_crypto.h"
 #include "skycoin_check_signature.h"
@@ -411,6 +413,115 @@ START_TEST(test_checkdigest)
 }
 END_TEST
 
+START_TEST(test_verify_digest_pubkeys)
+{
+    uint8_t digest[32];
+    uint8_t seckey[32];
+    uint8_t pubkeys[VERIFY_BATCH_MAX][33];
+    uint8_t signatures[VERIFY_BATCH_MAX][65];
+    const uint8_t *keys[VERIFY_BATCH_MAX];
+    const uint8_t *sigs[VERIFY_BATCH_MAX];
+    const char *seckeys[VERIFY_BATCH_MAX] = {
+        "597e27368656cab3c82bfcf2fb074cefd8b6101781a27709ba1b326b738d2c5a",
+        "a7e130694166cdb95b1e1bbce3f21e4dbd63f46df42b48c5a1f8295033d57d04",
+        "001aa9e416aff5f3a3c7f9ae0811757cf54f393d50df861f5c33747954341aa7",
+    };
+    memcpy(digest, fromhex("001aa9e416aff5f3a3c7f9ae0811757cf54f393d50df861f5c33747954341aa7"), 32);
+    for (int i = 0; i < VERIFY_BATCH_MAX; i++) {
+        memcpy(seckey, fromhex(seckeys[i]), 32);
+        ck_assert_int_eq(ecdsa_skycoin_sign(0x1e2501ac + i, seckey, digest, signatures[i]), 0);
+        ck_assert_int_eq(recover_pubkey_from_signed_message((char*)digest, signatures[i], pubkeys[i]), 0);
+        keys[i] = pubkeys[i];
+        sigs[i] = signatures[i];
+    }
+
+    ck_assert_int_eq(verify_digest_pubkeys(keys, sigs, VERIFY_BATCH_MAX, digest), 0);
+    ck_assert_int_eq(verify_digest_pubkeys(keys, sigs, 1, digest), 0);
+
+    // signature checked against another key
+    keys[1] = pubkeys[2];
+    ck_assert_int_ne(verify_digest_pubkeys(keys, sigs, VERIFY_BATCH_MAX, digest), 0);
+    keys[1] = pubkeys[1];
+
+    // tampered signature
+    signatures[2][40] ^= 0x01;
+    ck_assert_int_ne(verify_digest_pubkeys(keys, sigs, VERIFY_BATCH_MAX, digest), 0);
+    signatures[2][40] ^= 0x01;
+
+    // tampered digest
+    digest[5] ^= 0x80;
+    ck_assert_int_ne(verify_digest_pubkeys(keys, sigs, VERIFY_BATCH_MAX, digest), 0);
+    digest[5] ^= 0x80;
+
+    // zero s
+    memset(signatures[0] + 32, 0, 32);
+    ck_assert_int_ne(verify_digest_pubkeys(keys, sigs, VERIFY_BATCH_MAX, digest), 0);
+
+    ck_assert_int_ne(verify_digest_pubkeys(keys, sigs, 0, digest), 0);
+    ck_assert_int_ne(verify_digest_pubkeys(keys, sigs, VERIFY_BATCH_MAX + 1, digest), 0);
+}
+END_TEST
+
+START_TEST(test_opcount)
+{
+    char seed[256] = "seed";
+    uint8_t seckey[32] = {0};
+    uint8_t pubkey[33] = {0};
+    uint8_t nextSeed[SHA256_DIGEST_LENGTH] = {0};
+    uint8_t digest[32] = {0};
+    uint8_t signature[65] = {0};
+    skycoin_opcount keypair, sign, recover;
+
+    opcount_reset();
+    generate_deterministic_key_pair_iterator((const uint8_t*)seed, strlen(seed), nextSeed, seckey, pubkey);
+    opcount_get(&keypair);
+
+    memcpy(digest, fromhex("001aa9e416aff5f3a3c7f9ae0811757cf54f393d50df861f5c33747954341aa7"), 32);
+    opcount_reset();
+    ck_assert_int_eq(ecdsa_skycoin_sign(1, seckey, digest, signature), 0);
+    opcount_get(&sign);
+
+    opcount_reset();
+    ck_assert_int_eq(recover_pubkey_from_signed_message((char*)digest, signature, pubkey), 0);
+    opcount_get(&recover);
+
+#if SKYCOIN_OPCOUNT
+    opcount_print("generate_deterministic_key_pair_iterator", &keypair);
+    opcount_print("ecdsa_skycoin_sign", &sign);
+    opcount_print("recover_pubkey_from_signed_message", &recover);
+    ck_assert(keypair.point_add > 0 && keypair.field_inv > 0 && keypair.sha256_compress > 0);
+    ck_assert(sign.field_mul > 0 && sign.field_inv > 0);
+    ck_assert(recover.field_sqrt == 1 && recover.point_double > 0);
+#else
+    ck_assert(keypair.field_mul == 0 && sign.field_mul == 0 && recover.field_mul == 0);
+#endif
+}
+END_TEST
+
+START_TEST(test_mnemonic_find_word)
+{
+    ck_assert_int_eq(mnemonic_find_word("abandon"), 0);
+    ck_assert_int_eq(mnemonic_find_word("ability"), 1);
+    ck_assert_int_eq(mnemonic_find_word("zone"), 2046);
+    ck_assert_int_eq(mnemonic_find_word("zoo"), 2047);
+    ck_assert_int_eq(mnemonic_find_word("legal"), 1019);
+
+    // the unique 4 letter prefixes of the words are not words themselves
+    ck_assert_int_eq(mnemonic_find_word("aban"), -1);
+    ck_assert_int_eq(mnemonic_find_word("abil"), -1);
+    ck_assert_int_eq(mnemonic_find_word("zebr"), -1);
+
+    // not in the list
+    ck_assert_int_eq(mnemonic_find_word(""), -1);
+    ck_assert_int_eq(mnemonic_find_word("a"), -1);
+    ck_assert_int_eq(mnemonic_find_word("aaaa"), -1);
+    ck_assert_int_eq(mnemonic_find_word("zzzz"), -1);
+    ck_assert_int_eq(mnemonic_find_word("abandons"), -1);
+    ck_assert_int_eq(mnemonic_find_word("Abandon"), -1);
+    ck_assert_int_eq(mnemonic_find_word("skycoin"), -1);
+}
+END_TEST
+
 // define test suite and cases
 Suite *test_suite(void)
 {
@@ -431,6 +542,9 @@ Suite *test_suite(void)
     tcase_add_test(tc, test_base58_decode);
     tcase_add_test(tc, test_signature);
     tcase_add_test(tc, test_checkdigest);
+    tcase_add_test(tc, test_verify_digest_pubkeys);
+    tcase_add_test(tc, test_opcount);
+    tcase_add_test(tc, test_mnemonic_find_word);
     suite_add_tcase(s, tc);
 
     return s;
@@ -28,6 +28,7 @@
 #include "sha2.h"
 #include "ripemd160.h"
 #include "memzero.h"
+#include "perf_span.h"
 
 static const int8_t b58digits_map[] = {
 	-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
@@ -40,7 +41,7 @@ static const int8_t b58digits_map[] = {
 	47,48,49,50,51,52,53,54,55,56,57,-1,-1,-1,-1,-1,
 };
 
-bool b58tobin(void *bin, size_t *binszp, const char *b58)
+static bool b58tobin_digits(void *bin, size_t *binszp, const char *b58)
 {
 	size_t binsz = *binszp;
 	const unsigned char *b58u = (const unsigned char*)b58;
@@ -123,6 +124,14 @@ bool b58tobin(void *bin, size_t *binszp, const char *b58)
 	return true;
 }
 
+bool b58tobin(void *bin, size_t *binszp, const char *b58)
+{
+	perf_span_begin(PERF_SPAN_BASE58);
+	bool res = b58tobin_digits(bin, binszp, b58);
+	perf_span_end(PERF_SPAN_BASE58);
+	return res;
+}
+
 int b58check(const void *bin, size_t binsz, HasherType hasher_type, const char *base58str)
 {
 	unsigned char buf[32];
@@ -153,6 +162,7 @@ bool b58enc(char *b58, size_t *b58sz, const void *data, size_t binsz)
 	ssize_t i, j, high, zcount = 0;
 	size_t size;
 
+	perf_span_begin(PERF_SPAN_BASE58);
 	while (zcount < (ssize_t)binsz && !bin[zcount])
 		++zcount;
 
@@ -175,6 +185,7 @@ bool b58enc(char *b58, size_t *b58sz, const void *data, size_t binsz)
 	if (*b58sz <= zcount + size - j)
 	{
 		*b58sz = zcount + size - j + 1;
+		perf_span_end(PERF_SPAN_BASE58);
 		return false;
 	}
 
@@ -185,6 +196,7 @@ bool b58enc(char *b58, size_t *b58sz, const void *data, size_t binsz)
 	b58[i] = '\0';
 	*b58sz = i + 1;
 
+	perf_span_end(PERF_SPAN_BASE58);
 	return true;
 }
 
@@ -28,6 +28,7 @@
 #include <assert.h>
 #include "bignum.h"
 #include "memzero.h"
+#include "opcount.h"
 
 /* big number library */
 
@@ -488,6 +489,11 @@ void bn_multiply_reduce(bignum256 *x, uint32_t res[18], const bignum256 *prime)
 void bn_multiply(const bignum256 *k, bignum256 *x, const bignum256 *prime)
 {
 	uint32_t res[18] = {0};
+	if (k == x) {
+		OPCOUNT(field_sqr);
+	} else {
+		OPCOUNT(field_mul);
+	}
 	bn_multiply_long(k, x, res);
 	bn_multiply_reduce(x, res, prime); 
 	memzero(res, sizeof(res));
@@ -525,6 +531,7 @@ void bn_sqrt(bignum256 *x, const bignum256 *prime)
 	// this method compute x^1/2 = x^(prime+1)/4
 	uint32_t i, j, limb;
 	bignum256 res, p;
+	OPCOUNT(field_sqrt);
 	bn_one(&res);
 	// compute p = (prime+1)/4
 	memcpy(&p, prime, sizeof(bignum256));
@@ -564,6 +571,7 @@ void bn_inverse(bignum256 *x, const bignum256 *prime)
 	// this method compute x^-1 = x^(prime-2)
 	uint32_t i, j, limb;
 	bignum256 res;
+	OPCOUNT(field_inv);
 	bn_one(&res);
 	for (i = 0; i < 9; i++) {
 		// invariants:
@@ -606,6 +614,7 @@ void bn_inverse(bignum256 *x, const bignum256 *prime)
 	uint32_t pp[8];
 	uint32_t temp32;
 	uint64_t temp;
+	OPCOUNT(field_inv);
 
 	// The algorithm is based on Schroeppel et. al. "Almost Modular Inverse"
 	// algorithm.  We keep four values u,v,r,s in the combo registers
@@ -37,6 +37,8 @@
 #include "secp256k1.h"
 // #include "rfc6979.h"
 #include "memzero.h"
+#include "perf_span.h"
+#include "opcount.h"
 
 // Set cp2 = cp1
 void point_copy(const curve_point *cp1, curve_point *cp2)
@@ -48,6 +50,7 @@ void point_copy(const curve_point *cp1, curve_point *cp2)
 void point_add(const ecdsa_curve *curve, const curve_point *cp1, curve_point *cp2)
 {
 	bignum256 lambda, inv, xr, yr;
+	OPCOUNT(point_add);
 
 	if (point_is_infinity(cp1)) {
 		return;
@@ -94,6 +97,7 @@ void point_add(const ecdsa_curve *curve, const curve_point *cp1, curve_point *cp
 void point_double(const ecdsa_curve *curve, curve_point *cp)
 {
 	bignum256 lambda, xr, yr;
+	OPCOUNT(point_double);
 
 	if (point_is_infinity(cp)) {
 		return;
@@ -243,6 +247,7 @@ void point_jacobian_add(const curve_point *p1, jacobian_curve_point *p2, const e
 	int is_doubling;
 	const bignum256 *prime = &curve->prime;
 	int a = curve->a;
+	OPCOUNT(point_add);
 
 	assert (-3 <= a && a <= 0);
 
@@ -358,6 +363,7 @@ void point_jacobian_add(const curve_point *p1, jacobian_curve_point *p2, const e
 void point_jacobian_double(jacobian_curve_point *p, const ecdsa_curve *curve) {
 	bignum256 az4, m, msq, ysq, xysq;
 	const bignum256 *prime = &curve->prime;
+	OPCOUNT(point_double);
 
 	assert (-3 <= curve->a && curve->a <= 0);
 	/* usual algorithm:
@@ -464,6 +470,7 @@ void point_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_po
 		point_set_infinity(res);
 		return;
 	}
+	perf_span_begin(PERF_SPAN_SCALAR_MULTIPLY);
 
 	// Now a = k + 2^256 (mod curve->order) and a is odd.
 	//
@@ -543,6 +550,7 @@ void point_multiply(const ecdsa_curve *curve, const bignum256 *k, const curve_po
 	jacobian_to_curve(&jres, res, prime);
 	memzero(&a, sizeof(a));
 	memzero(&jres, sizeof(jres));
+	perf_span_end(PERF_SPAN_SCALAR_MULTIPLY);
 }
 
 #if USE_PRECOMPUTED_CP
@@ -581,6 +589,7 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *
 		point_set_infinity(res);
 		return;
 	}
+	perf_span_begin(PERF_SPAN_SCALAR_MULTIPLY);
 
 	// Now a = k + 2^256 (mod curve->order) and a is odd.
 	//
@@ -631,6 +640,7 @@ void scalar_multiply(const ecdsa_curve *curve, const bignum256 *k, curve_point *
 	jacobian_to_curve(&jres, res, prime);
 	memzero(&a, sizeof(a));
 	memzero(&jres, sizeof(jres));
+	perf_span_end(PERF_SPAN_SCALAR_MULTIPLY);
 }
 
 #else
@@ -0,0 +1,33 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "opcount.h"
+
+#if SKYCOIN_OPCOUNT
+skycoin_opcount opcount;
+#endif
+
+void opcount_reset(void)
+{
+#if SKYCOIN_OPCOUNT
+	memset(&opcount, 0, sizeof(opcount));
+#endif
+}
+
+void opcount_get(skycoin_opcount *counts)
+{
+#if SKYCOIN_OPCOUNT
+	*counts = opcount;
+#else
+	memset(counts, 0, sizeof(*counts));
+#endif
+}
+
+void opcount_print(const char *label, const skycoin_opcount *counts)
+{
+	printf("%s: mul %llu sqr %llu inv %llu sqrt %llu add %llu dbl %llu sha256 %llu\n", label,
+		(unsigned long long)counts->field_mul, (unsigned long long)counts->field_sqr,
+		(unsigned long long)counts->field_inv, (unsigned long long)counts->field_sqrt,
+		(unsigned long long)counts->point_add, (unsigned long long)counts->point_double,
+		(unsigned long long)counts->sha256_compress);
+}
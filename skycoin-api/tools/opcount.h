@@ -0,0 +1,37 @@
+#ifndef __OPCOUNT_H__
+#define __OPCOUNT_H__
+
+#include <stdint.h>
+
+#include "options.h"
+
+/*
+ * Operation counts of the bignum and elliptic curve layer, collected when
+ * built with SKYCOIN_OPCOUNT=1. Unlike timings they are the same on every
+ * platform. Multiplications include the ones inside square roots and
+ * scalar (mod order) arithmetic, squarings are bn_multiply calls with the
+ * same bignum as both operands.
+ */
+typedef struct {
+	uint64_t field_mul;
+	uint64_t field_sqr;
+	uint64_t field_inv;
+	uint64_t field_sqrt;
+	uint64_t point_add;
+	uint64_t point_double;
+	uint64_t sha256_compress;
+} skycoin_opcount;
+
+#if SKYCOIN_OPCOUNT
+extern skycoin_opcount opcount;
+#define OPCOUNT(op) (opcount.op++)
+#else
+#define OPCOUNT(op)
+#endif
+
+// counts are all zero unless built with SKYCOIN_OPCOUNT=1
+void opcount_reset(void);
+void opcount_get(skycoin_opcount *counts);
+void opcount_print(const char *label, const skycoin_opcount *counts);
+
+#endif
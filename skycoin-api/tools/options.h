@@ -74,6 +74,16 @@
 #define USE_KECCAK 1
 #endif
 
+// time hot primitives through the hooks in perf_span.h
+#ifndef USE_PERF_SPANS
+#define USE_PERF_SPANS 0
+#endif
+
+// count field and curve operations, see opcount.h
+#ifndef SKYCOIN_OPCOUNT
+#define SKYCOIN_OPCOUNT 0
+#endif
+
 // add way how to mark confidential data
 #ifndef CONFIDENTIAL
 #define CONFIDENTIAL
@@ -0,0 +1,22 @@
+#ifndef __PERF_SPAN_H__
+#define __PERF_SPAN_H__
+
+#include "options.h"
+
+// hot primitives timed by the firmware profiler (tiny-firmware/firmware/perf.c)
+typedef enum {
+	PERF_SPAN_SECP256K1_HASH,
+	PERF_SPAN_SCALAR_MULTIPLY,
+	PERF_SPAN_BASE58,
+	PERF_SPAN_COUNT,
+} perf_span;
+
+#if USE_PERF_SPANS
+void perf_span_begin(perf_span span);
+void perf_span_end(perf_span span);
+#else
+#define perf_span_begin(span)
+#define perf_span_end(span)
+#endif
+
+#endif
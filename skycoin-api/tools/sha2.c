@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include "sha2.h"
 #include "memzero.h"
+#include "opcount.h"
 
 /*
  * ASSERT NOTE:
@@ -739,6 +740,7 @@ void sha256_Transform(const sha2_word32* state_in, const sha2_word32* data, sha2
 	sha2_word32	T1;
 	sha2_word32 W256[16];
 	int		j;
+	OPCOUNT(sha256_compress);
 
 	/* Initialize registers with the prev. intermediate value */
 	a = state_in[0];
@@ -795,6 +797,7 @@ void sha256_Transform(const sha2_word32* state_in, const sha2_word32* data, sha2
 	sha2_word32	a, b, c, d, e, f, g, h, s0, s1;
 	sha2_word32	T1, T2, W256[16];
 	int		j;
+	OPCOUNT(sha256_compress);
 
 	/* Initialize registers with the prev. intermediate value */
 	a = state_in[0];
@@ -160,21 +160,16 @@ int mnemonic_check(const char *mnemonic)
 		}
 		current_word[j] = 0;
 		if (mnemonic[i] != 0) i++;
-		k = 0;
-		for (;;) {
-			if (!wordlist[k]) { // word not found
-				return 0;
-			}
-			if (strcmp(current_word, wordlist[k]) == 0) { // word found on index k
-				for (ki = 0; ki < 11; ki++) {
-					if (k & (1 << (10 - ki))) {
-						bits[bi / 8] |= 1 << (7 - (bi % 8));
-					}
-					bi++;
-				}
-				break;
+		int idx = mnemonic_find_word(current_word);
+		if (idx < 0) { // word not found
+			return 0;
+		}
+		k = idx;
+		for (ki = 0; ki < 11; ki++) {
+			if (k & (1 << (10 - ki))) {
+				bits[bi / 8] |= 1 << (7 - (bi % 8));
 			}
-			k++;
+			bi++;
 		}
 	}
 	if (bi != n * 11) {
@@ -194,6 +189,25 @@ int mnemonic_check(const char *mnemonic)
 	return 0;
 }
 
+// the wordlist is sorted, so a word is found by binary search
+int mnemonic_find_word(const char *word)
+{
+	int lo = 0, hi = BIP39_WORDS - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = strcmp(word, wordlist[mid]);
+		if (cmp == 0) {
+			return mid;
+		}
+		if (cmp < 0) {
+			hi = mid - 1;
+		} else {
+			lo = mid + 1;
+		}
+	}
+	return -1;
+}
+
 const char * const *mnemonic_wordlist(void)
 {
 	return wordlist;
@@ -27,6 +27,7 @@
 #include <stdint.h>
 
 #define BIP39_PBKDF2_ROUNDS 2048
+#define BIP39_WORDS 2048
 
 const char *mnemonic_generate(int strength);	// strength in bits
 const uint16_t *mnemonic_generate_indexes(int strength);	// strength in bits
@@ -39,6 +40,9 @@ int mnemonic_check(const char *mnemonic);
 // passphrase must be at most 256 characters or code may crash
 void mnemonic_to_seed(const char *mnemonic, const char *passphrase, uint8_t seed[512 / 8], void (*progress_callback)(uint32_t current, uint32_t total));
 
+// index of word in the wordlist, -1 if it is not there
+int mnemonic_find_word(const char *word);
+
 const char * const *mnemonic_wordlist(void);
 
 #endif
@@ -105,7 +105,7 @@ void __attribute__((noreturn)) load_app(int signed_firmware)
 bool firmware_present(void)
 {
 #ifndef APPVER
-	if (memcmp((const void *)FLASH_META_MAGIC, "SKY1", 4)) { // magic does not match
+	if (memcmp((const void *)FLASH_META_MAGIC, FIRMWARE_MAGIC, 4) && memcmp((const void *)FLASH_META_MAGIC, FIRMWARE_MAGIC_SECTORS, 4)) { // magic does not match
 		return false;
 	}
 	if (*((const uint32_t *)FLASH_META_CODELEN) < 4096) { // firmware reports smaller size than 4kB
@@ -34,6 +34,9 @@
 #include <stdbool.h>
 #include "memory.h"
 
+#define FIRMWARE_MAGIC "SKY1"
+#define FIRMWARE_MAGIC_SECTORS "SKY2"	// signed per code sector, see memory.h
+
 void layoutFirmwareHash(const uint8_t *hash);
 #if SIGNATURE_DEBUG
 void layout32bits(const uint8_t *buffer, const char* message);
@@ -1,11 +1,13 @@
 #!/usr/bin/env python
 from __future__ import print_function
 
-bl = open('bl.bin').read()
-fw = open('fw.bin').read()
-combined = bl + fw[:256] + (32768-256)*'\x00' + fw[256:]
+bl = open('bl.bin', 'rb').read()
+fw = open('fw.bin', 'rb').read()
+# SKY2 images carry the code sector hashes after the header, they are not flashed
+code = fw[256 + 4 * 32:] if fw[:4] == b'SKY2' else fw[256:]
+combined = bl + fw[:256] + (32768-256)*b'\x00' + code
 
-open('combined.bin', 'w').write(combined)
+open('combined.bin', 'wb').write(combined)
 
 print('bootloader : %d bytes' % len(bl))
 print('firmware   : %d bytes' % len(fw))
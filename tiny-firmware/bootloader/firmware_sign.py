@@ -22,38 +22,68 @@ pubkeys = {
     5: '033bdf377502789d27a1d534775392af97a93333181b9736395b3db687ceffc473',
 }
 
-INDEXES_START = len('SKY1') + struct.calcsize('<I')
+MAGIC = b'SKY1'          # signed sha256 of the code
+MAGIC_SECTORS = b'SKY2'  # signed Merkle root of the code sector hashes
+META_LEN = 256
+# code sectors 4-7 of the device, see memory.h
+CODE_SECTORS = [0x10000, 0x20000, 0x20000, 0x20000]
+
+INDEXES_START = len(MAGIC) + struct.calcsize('<I')
 SIG_START = INDEXES_START + SLOTS + 1 + 52
 
 def parse_args():
     parser = argparse.ArgumentParser(description='Commandline tool for signing Trezor firmware.')
     parser.add_argument('-f', '--file', dest='path', help="Firmware file to modify")
     parser.add_argument('-s', '--sign', dest='sign', action='store_true', help="Add signature to firmware slot")
+    parser.add_argument('-S', '--sectors', dest='sectors', action='store_true', help="Add a SKY2 header with sector hashes, needs a bootloader that knows SKY2")
 
     return parser.parse_args()
 
-def prepare(data):
+def code_start(data):
+    # SKY2 images carry the sector hashes between the header and the code
+    return META_LEN + (32 * len(CODE_SECTORS) if data[:4] == MAGIC_SECTORS else 0)
+
+def sector_hashes(code):
+    hashes = []
+    start = 0
+    for size in CODE_SECTORS:
+        hashes.append(hashlib.sha256(code[start:start + size]).digest())
+        start += size
+    return hashes
+
+def merkle_root(hashes):
+    while len(hashes) > 1:
+        hashes = [hashlib.sha256(hashes[i] + hashes[i + 1]).digest() for i in range(0, len(hashes), 2)]
+    return hashes[0]
+
+def image_fingerprint(data):
+    # Digest the bootloader checks the signatures against
+    code = data[code_start(data):]
+    if data[:4] == MAGIC_SECTORS:
+        return binascii.hexlify(merkle_root(sector_hashes(code))).decode('ascii')
+    return hashlib.sha256(code).hexdigest()
+
+def prepare(data, magic=MAGIC):
     # Takes raw OR signed firmware and clean out metadata structure
     # This produces 'clean' data for signing
 
-    meta = b'SKY1'  # magic
-    if data[:4] == b'SKY1':
-        meta += data[4:4 + struct.calcsize('<I')]
+    if data[:4] in (MAGIC, MAGIC_SECTORS):
+        magic = data[:4]
+        code = data[code_start(data):]
     else:
-        meta += struct.pack('<I', len(data))  # length of the code
+        code = data
+
+    meta = magic
+    meta += struct.pack('<I', len(code))  # length of the code
     meta += b'\x00' * SLOTS  # signature index #1-#3
     meta += b'\x01'       # flags
     meta += b'\x00' * 52  # reserved
     meta += b'\x00' * 64 * SLOTS  # signature #1-#3
 
-    if data[:4] == b'SKY1':
-        # Replace existing header
-        out = meta + data[len(meta):]
-    else:
-        # create data from meta + code
-        out = meta + data
+    if magic == MAGIC_SECTORS:
+        meta += b''.join(sector_hashes(code))
 
-    return out
+    return meta + code
 
 def check_signatures(data):
     # Analyses given firmware and prints out
@@ -64,8 +94,7 @@ def check_signatures(data):
     except:
         indexes = [ x for x in data[INDEXES_START:INDEXES_START + SLOTS] ]
 
-    to_sign = prepare(data)[256:] # without meta
-    fingerprint = hashlib.sha256(to_sign).hexdigest()
+    fingerprint = image_fingerprint(data)
     print("Firmware fingerprint:", fingerprint)
 
     used = []
@@ -120,8 +149,7 @@ def sign(data):
     pubkey = skycoin.GeneratePubkeyFromSeckey(seckey)
     pubkey = binascii.hexlify(pubkey.value)
 
-    to_sign = prepare(data)[256:] # without meta
-    fingerprint = hashlib.sha256(to_sign).hexdigest()
+    fingerprint = image_fingerprint(data)
     print("Firmware fingerprint:", fingerprint)
 
     # Locate proper index of current signing key
@@ -154,11 +182,11 @@ def main(args):
     data = open(args.path, 'rb').read()
     assert len(data) % 4 == 0
 
-    if data[:4] != b'SKY1':
+    if data[:4] not in (MAGIC, MAGIC_SECTORS):
         print("Metadata has been added...")
-        data = prepare(data)
+        data = prepare(data, MAGIC_SECTORS if args.sectors else MAGIC)
 
-    if data[:4] != b'SKY1':
+    if data[:4] not in (MAGIC, MAGIC_SECTORS):
         raise Exception("Firmware header expected")
 
     print("Firmware size %d bytes" % len(data))
@@ -22,37 +22,31 @@
 
 #include "signatures.h"
 #include "skycoin_check_signature.h"
+#include "skycoin_check_signature_tools.h"
 #include "sha2.h"
 #include "bootloader.h"
 
-#define PUBKEYS 5
-
 #if SIGNATURE_PROTECT
-static const uint8_t * const pubkey[PUBKEYS] = {
-	(const uint8_t *)"\x02\x42\x91\xe2\x42\x5a\x2f\xc7\xec\x7b\xd7\x5c\x81\x28\x72\x6c\xa8\xcf\xb7\xce\x9c\x04\xae\x81\x86\xb6\x6c\x35\x16\xf0\xf8\x0c\xd2",
-	(const uint8_t *)"\x03\xe5\x92\xcb\x31\xc3\xc2\xcc\x9b\x38\x10\xe5\xc7\x82\x98\x28\x0b\x0c\xc7\x85\xcd\x7f\x28\xe3\x6e\x13\x5a\xa8\xa0\xfc\x74\xd0\x81",
-	(const uint8_t *)"\x03\xb1\x55\xdf\x34\xb4\xc0\x87\x9f\xdd\x6b\xde\x2a\xcb\x9c\x7a\x45\xe9\x3a\xa0\xbd\x0c\x69\x7f\x62\x92\xdc\x3d\x1c\xb4\xc5\x96\xd6",
-	(const uint8_t *)"\x02\x6d\x1d\x2e\x1c\x4a\xf5\xa2\xc8\x9e\x8e\x4c\x8b\xf7\x24\x03\x4d\x02\x52\xeb\x8b\x91\x79\xfc\x6e\xec\x9c\xeb\x8b\xb1\x73\x49\x97",
-	(const uint8_t *)"\x03\x3b\xdf\x37\x75\x02\x78\x9d\x27\xa1\xd5\x34\x77\x53\x92\xaf\x97\xa9\x33\x33\x18\x1b\x97\x36\x39\x5b\x3d\xb6\x87\xce\xff\xc4\x73",
-};
+// pubkey[], pubkey_table[] and generator_table[]
+#include "signatures_table.h"
 #endif
 
 #define SIGNATURES 3
 
 
 #if SIGNATURE_DEBUG
-static void displaySignatureDebug(const uint8_t *hash, const uint8_t *signature, 
-const uint8_t *pubk, const uint8_t *stored_pubkey)
+static void displaySignatureDebug(const uint8_t *hash, const uint8_t *signature, const uint8_t *stored_pubkey)
 {
 	layout32bits(hash, "Hash");
 	layout32bits(signature, "Signature[0-31]");
 	layout32bits(signature + 32, "Signature[32-64]");
-	layout32bits(pubk, "Computed Pub");
 	layout32bits(stored_pubkey, "Pubkey");
 
 }
 #endif
 
+static int signatures_match(const uint8_t *code_hash);
+
 int signatures_ok(uint8_t *store_hash)
 {
 	if (!firmware_present()) return SIG_FAIL; // no firmware present
@@ -60,13 +54,57 @@ int signatures_ok(uint8_t *store_hash)
 	const uint32_t codelen = *((const uint32_t *)FLASH_META_CODELEN);
 	
 	uint8_t hash[32];
-	sha256_Raw((const uint8_t *)FLASH_APP_START, codelen, hash);
+	if (0 == memcmp((const void *)FLASH_META_MAGIC, FIRMWARE_MAGIC_SECTORS, 4)) {
+		uint8_t sector_hashes[FLASH_CODE_SECTORS][32];
+		signatures_sector_hashes(codelen, sector_hashes);
+		signatures_merkle_root(sector_hashes, hash);
+	} else {
+		sha256_Raw((const uint8_t *)FLASH_APP_START, codelen, hash);
+	}
 	if (store_hash) {
 		memcpy(store_hash, hash, 32);
 	}
 
+	return signatures_match(hash);
+}
+
+/* sha256 of the part of the code in each code sector, as installed
+ */
+void signatures_sector_hashes(uint32_t codelen, uint8_t hashes[FLASH_CODE_SECTORS][32])
+{
+	const uint32_t code_end = FLASH_APP_START + codelen;
+	for (int i = 0; i < FLASH_CODE_SECTORS; i++) {
+		uint32_t start = FLASH_SECTOR_START(FLASH_CODE_SECTOR_FIRST + i);
+		uint32_t end = FLASH_SECTOR_START(FLASH_CODE_SECTOR_FIRST + i + 1);
+		if (end > code_end) end = code_end;
+		sha256_Raw((const uint8_t *)start, start < end ? end - start : 0, hashes[i]);
+	}
+}
+
+/* sha256(sha256(h0 || h1) || sha256(h2 || h3)) for the four code sectors
+ */
+void signatures_merkle_root(const uint8_t hashes[FLASH_CODE_SECTORS][32], uint8_t *root)
+{
+	uint8_t level[FLASH_CODE_SECTORS][32];
+	memcpy(level, hashes, sizeof(level));
+	for (int n = FLASH_CODE_SECTORS; n > 1; n /= 2) {
+		for (int i = 0; i < n / 2; i++) {
+			sha256_Raw(level[2 * i], 64, level[i]);
+		}
+	}
+	memcpy(root, level[0], 32);
+}
+
+/* Checks the signatures in the metadata against code_hash, the digest of
+ * the installed code computed by signatures_ok().
+ */
+static int signatures_match(const uint8_t *code_hash)
+{
 #if SIGNATURE_PROTECT
 
+	uint8_t hash[32];
+	memcpy(hash, code_hash, sizeof(hash));
+
 	const uint8_t sigindex1 = *((const uint8_t *)FLASH_META_SIGINDEX1);
 	const uint8_t sigindex2 = *((const uint8_t *)FLASH_META_SIGINDEX2);
 	const uint8_t sigindex3 = *((const uint8_t *)FLASH_META_SIGINDEX3);
@@ -79,41 +117,34 @@ int signatures_ok(uint8_t *store_hash)
 	if (sigindex1 == sigindex3) return SIG_FAIL; // duplicate use
 	if (sigindex2 == sigindex3) return SIG_FAIL; // duplicate use
 
-	uint8_t pubkey1[33];
-	uint8_t pubkey2[33];
-	uint8_t pubkey3[33];
-
-	uint8_t sign1[65];
-	uint8_t sign2[65];
-	uint8_t sign3[65];
+	const uint8_t sigindex[SIGNATURES] = {sigindex1, sigindex2, sigindex3};
+	const uint8_t *sigs[SIGNATURES] = {
+		(const uint8_t *)FLASH_META_SIG1,
+		(const uint8_t *)FLASH_META_SIG2,
+		(const uint8_t *)FLASH_META_SIG3,
+	};
+	const curve_point *qtables[SIGNATURES];
+	for (int i = 0; i < SIGNATURES; i++) {
+		qtables[i] = pubkey_table[sigindex[i] - 1];
+	}
 
-	memcpy(sign1, (const uint8_t *)FLASH_META_SIG1, 64);
-	recover_pubkey_from_signed_message((char*)hash, sign1, pubkey1);
-	if (0 != memcmp(pubkey1, pubkey[sigindex1 - 1], 33)) // failure
+	// all three against the known keys in one batch, nothing is recovered
+	if (0 != verify_digest_tables(&msecp256k1, generator_table, qtables, sigs, SIGNATURES, hash)) // failure
 	{
 #if SIGNATURE_DEBUG
-		displaySignatureDebug(hash, sign1, pubkey1, pubkey[sigindex1 - 1]);
+		for (int i = 0; i < SIGNATURES; i++) {
+			if (0 != verify_digest_tables(&msecp256k1, generator_table, &qtables[i], &sigs[i], 1, hash)) {
+				displaySignatureDebug(hash, sigs[i], pubkey[sigindex[i] - 1]);
+				break;
+			}
+		}
+#else
+		(void)pubkey;
 #endif
 		return SIG_FAIL;
-	} 
-	memcpy(sign2, (const uint8_t *)FLASH_META_SIG2, 64);
-	recover_pubkey_from_signed_message((char*)hash, sign2, pubkey2);
-	if (0 != memcmp(pubkey2, pubkey[sigindex2 - 1], 33)) // failure
-	{
-#if SIGNATURE_DEBUG
-		displaySignatureDebug(hash, sign2, pubkey2, pubkey[sigindex2 - 1]);
-#endif
-		return SIG_FAIL;
-	} 
-	memcpy(sign3, (const uint8_t *)FLASH_META_SIG3, 64);
-	recover_pubkey_from_signed_message((char*)hash, sign3, pubkey3);
-	if (0 != memcmp(pubkey3, pubkey[sigindex3 - 1], 33)) // failure
-	{
-#if SIGNATURE_DEBUG
-		displaySignatureDebug(hash, sign3, pubkey3, pubkey[sigindex3 - 1]);
-#endif
-		return SIG_FAIL;
-	} 
+	}
+#else
+	(void)code_hash;
 #endif
 
 	return SIG_OK;
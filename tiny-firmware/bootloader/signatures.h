@@ -20,9 +20,14 @@
 #ifndef __SIGNATURES_H__
 #define __SIGNATURES_H__
 
+#include <stdint.h>
+#include "memory.h"
+
 #define SIG_OK      0x5A3CA5C3
 #define SIG_FAIL    0x00000000
 
 int signatures_ok(uint8_t *store_hash);
+void signatures_sector_hashes(uint32_t codelen, uint8_t hashes[FLASH_CODE_SECTORS][32]);
+void signatures_merkle_root(const uint8_t hashes[FLASH_CODE_SECTORS][32], uint8_t *root);
 
 #endif
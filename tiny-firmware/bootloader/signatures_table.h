@@ -0,0 +1,171 @@
+// generated by signatures_table.py, do not edit
+
+#define PUBKEYS 5
+
+static const uint8_t * const pubkey[PUBKEYS] = {
+	(const uint8_t *)"\x02\x42\x91\xe2\x42\x5a\x2f\xc7\xec\x7b\xd7\x5c\x81\x28\x72\x6c\xa8\xcf\xb7\xce\x9c\x04\xae\x81\x86\xb6\x6c\x35\x16\xf0\xf8\x0c\xd2",
+	(const uint8_t *)"\x03\xe5\x92\xcb\x31\xc3\xc2\xcc\x9b\x38\x10\xe5\xc7\x82\x98\x28\x0b\x0c\xc7\x85\xcd\x7f\x28\xe3\x6e\x13\x5a\xa8\xa0\xfc\x74\xd0\x81",
+	(const uint8_t *)"\x03\xb1\x55\xdf\x34\xb4\xc0\x87\x9f\xdd\x6b\xde\x2a\xcb\x9c\x7a\x45\xe9\x3a\xa0\xbd\x0c\x69\x7f\x62\x92\xdc\x3d\x1c\xb4\xc5\x96\xd6",
+	(const uint8_t *)"\x02\x6d\x1d\x2e\x1c\x4a\xf5\xa2\xc8\x9e\x8e\x4c\x8b\xf7\x24\x03\x4d\x02\x52\xeb\x8b\x91\x79\xfc\x6e\xec\x9c\xeb\x8b\xb1\x73\x49\x97",
+	(const uint8_t *)"\x03\x3b\xdf\x37\x75\x02\x78\x9d\x27\xa1\xd5\x34\x77\x53\x92\xaf\x97\xa9\x33\x33\x18\x1b\x97\x36\x39\x5b\x3d\xb6\x87\xce\xff\xc4\x73",
+};
+
+static const curve_point pubkey_table[PUBKEYS][8] = {
+	{
+		/*  1*pubkey[0]: */
+		{{{0x30f80cd2, 0x19b0d45b, 0x0ae8186b, 0x2df3a701, 0x326ca8cf, 0x1d7204a1, 0x3c7ec7bd, 0x3890968b, 0x4291}},
+		 {{0x3aab50cc, 0x1cac77bf, 0x0553a3b1, 0x279b55d4, 0x3ddf21bf, 0x1153cb57, 0x1095d36a, 0x19a9aa39, 0x5132}}},
+		/*  3*pubkey[0]: */
+		{{{0x2cb36d64, 0x286194a9, 0x09e8d9d3, 0x22afc94e, 0x1232dee0, 0x35a637ed, 0x331ebadf, 0x1c60ac68, 0x67d9}},
+		 {{0x12c7137c, 0x19dc2e12, 0x24e261dc, 0x01110672, 0x1a3ed8f8, 0x28d54278, 0x2a778a8f, 0x107bda3c, 0xd2ac}}},
+		/*  5*pubkey[0]: */
+		{{{0x2cfd2b15, 0x1e283e34, 0x020871ec, 0x36f12af6, 0x05abd998, 0x17e869f6, 0x18c77fe0, 0x30ef9e21, 0x528e}},
+		 {{0x08783912, 0x345a8ea1, 0x3cc6d443, 0x22ed884b, 0x14248d5a, 0x29688bb8, 0x3eee0851, 0x0726b83d, 0x8c25}}},
+		/*  7*pubkey[0]: */
+		{{{0x054a0893, 0x38c039d3, 0x271b5558, 0x19a83e21, 0x298299ab, 0x2376c221, 0x02414e1f, 0x38285b24, 0x619e}},
+		 {{0x1ca80d96, 0x280d9e41, 0x2d990907, 0x1dfe11f9, 0x0680abdd, 0x21a5b079, 0x12dc9c25, 0x1cedb49b, 0x5015}}},
+		/*  9*pubkey[0]: */
+		{{{0x02e0f376, 0x28c038bb, 0x2ad17549, 0x0aa3b2af, 0x06fa5822, 0x0022aab2, 0x0a754f58, 0x1633c81a, 0x607d}},
+		 {{0x2e969259, 0x0fcce74b, 0x21901dbc, 0x28909369, 0x1e9ea821, 0x02ed725f, 0x38f74bef, 0x27d5b0f2, 0xb417}}},
+		/* 11*pubkey[0]: */
+		{{{0x076f8921, 0x01eff89a, 0x1f3fd919, 0x256fb144, 0x0f767598, 0x312be195, 0x30a63cf9, 0x00909996, 0x434b}},
+		 {{0x1e671c9f, 0x3d17a6bc, 0x0c05856f, 0x0372d26c, 0x16078a2f, 0x04811ba9, 0x1266b342, 0x1dc07f88, 0x6f39}}},
+		/* 13*pubkey[0]: */
+		{{{0x3b0ccdbb, 0x059eea26, 0x34e8c2f7, 0x32adb84e, 0x372c48c0, 0x3ef55ad1, 0x37ff799b, 0x0592afbb, 0xd0e3}},
+		 {{0x219a1b2a, 0x2fe1c848, 0x201e61ea, 0x27288bfd, 0x15a311a1, 0x01e59774, 0x071868cf, 0x39b6d9b7, 0x685e}}},
+		/* 15*pubkey[0]: */
+		{{{0x3f1e0a8b, 0x136d6f98, 0x1c6e5523, 0x037e1c37, 0x30bb073a, 0x15acfc3d, 0x31ab59f1, 0x07772316, 0x5394}},
+		 {{0x0661a4cc, 0x160d8b06, 0x33f5e9bf, 0x028f75a6, 0x027baf30, 0x1fd678ff, 0x33e01c74, 0x0642c2dc, 0xa071}}},
+	},
+	{
+		/*  1*pubkey[1]: */
+		{{{0x3c74d081, 0x0d6aa283, 0x328e36e1, 0x31e1735f, 0x18280b0c, 0x03971e0a, 0x2cc9b381, 0x32cc70f0, 0xe592}},
+		 {{0x12532ac9, 0x19f12251, 0x0fb1969b, 0x03c1e1ec, 0x2b9fe3f5, 0x0c155485, 0x1b54ba2f, 0x13b16a5e, 0xd201}}},
+		/*  3*pubkey[1]: */
+		{{{0x198f78c4, 0x17c75e89, 0x00c18dec, 0x3b594f40, 0x2c44b1fd, 0x320b181e, 0x2b50d3f1, 0x270305b7, 0x7931}},
+		 {{0x2bcf2d67, 0x3a51a7dd, 0x2a2d6772, 0x0c5ed7a4, 0x1ab68a17, 0x2c65a3e4, 0x3cff3284, 0x078ae6ec, 0x73b7}}},
+		/*  5*pubkey[1]: */
+		{{{0x1604cb66, 0x3153dd2f, 0x1b84cf63, 0x0e9e3714, 0x3d69aa38, 0x320d867d, 0x2a590d2d, 0x0c88c9a2, 0x4ebb}},
+		 {{0x12d4930d, 0x073e4b1f, 0x2e20cd99, 0x23a16b78, 0x1b8a0405, 0x12c7ee77, 0x0baa3603, 0x1a8be133, 0x284e}}},
+		/*  7*pubkey[1]: */
+		{{{0x16f2f0a6, 0x371479ca, 0x26b4e98e, 0x1d9335fd, 0x20c788c1, 0x0056e328, 0x10a07236, 0x201e5741, 0xb911}},
+		 {{0x39ca9386, 0x08fecf7e, 0x2b0188b4, 0x2c568ddf, 0x09954805, 0x388eb86d, 0x2faeaa1c, 0x0f11177d, 0x1894}}},
+		/*  9*pubkey[1]: */
+		{{{0x17441eda, 0x2337b62c, 0x177b9538, 0x1b2e9c74, 0x0d7c4513, 0x23d14f52, 0x14cbcfed, 0x0a15666a, 0x4720}},
+		 {{0x1ac6a873, 0x17f39300, 0x16232136, 0x33ed54b9, 0x17721994, 0x023e5a74, 0x2e88ce74, 0x22895a63, 0x5ce7}}},
+		/* 11*pubkey[1]: */
+		{{{0x3b3cb4f4, 0x2725b352, 0x1d3585d1, 0x3c8f349c, 0x2ecdfb39, 0x1efc52ee, 0x1151ea54, 0x2917a110, 0x8ead}},
+		 {{0x2fe95993, 0x3d81fc5d, 0x282ae7b6, 0x3602f230, 0x17228a9b, 0x38d5bc3c, 0x28c4877d, 0x02823066, 0x6bb3}}},
+		/* 13*pubkey[1]: */
+		{{{0x0998014d, 0x08784221, 0x13a64eff, 0x14729698, 0x3b1941b2, 0x06fad598, 0x152b9ccd, 0x223add2d, 0x6ede}},
+		 {{0x2b164ae3, 0x3a98a678, 0x252624ec, 0x3044e31a, 0x0b810f1e, 0x2a394d14, 0x2e4bad24, 0x2c5e830b, 0xc7cd}}},
+		/* 15*pubkey[1]: */
+		{{{0x300034c4, 0x23d01d12, 0x3dbe76c9, 0x1db24489, 0x35760396, 0x379794ea, 0x2ee6f2d4, 0x12364a47, 0x4dbc}},
+		 {{0x142dba90, 0x360293d9, 0x1e9245bd, 0x3d6878d9, 0x07d0161c, 0x1193a9df, 0x1348dd7c, 0x01e9931a, 0xc5d0}}},
+	},
+	{
+		/*  1*pubkey[2]: */
+		{{{0x34c596d6, 0x0b70f472, 0x0697f629, 0x0ea82f43, 0x1c7a45e9, 0x2f78ab2e, 0x0879fdd6, 0x37cd2d30, 0xb155}},
+		 {{0x354d37cf, 0x1110ef80, 0x024eccca, 0x04648948, 0x3efd2b4c, 0x0bd56345, 0x02593623, 0x3341dc78, 0xba1d}}},
+		/*  3*pubkey[2]: */
+		{{{0x043a89e1, 0x23bf9041, 0x19878b28, 0x2eb681f5, 0x220fdd14, 0x31023580, 0x3894b47f, 0x207e35bd, 0xa015}},
+		 {{0x28afe1e6, 0x37790860, 0x2f84794f, 0x33e41b48, 0x1233ad19, 0x27503b62, 0x24219cf0, 0x3e5974c3, 0xb881}}},
+		/*  5*pubkey[2]: */
+		{{{0x196d1f45, 0x369da685, 0x16727d70, 0x17f0a4ee, 0x3a5da716, 0x1dd6f630, 0x24f48e70, 0x15dd83bf, 0x0fa8}},
+		 {{0x0bc63a09, 0x31fe59b0, 0x1eec745d, 0x1e1b531c, 0x3ac75245, 0x07cad056, 0x01a7279d, 0x2c61778f, 0x3e61}}},
+		/*  7*pubkey[2]: */
+		{{{0x0298861f, 0x1f39f250, 0x1201c03e, 0x1d855e4d, 0x13e7c709, 0x376fca7d, 0x2740b523, 0x0072364c, 0xa134}},
+		 {{0x0d2853bf, 0x16532212, 0x06b07399, 0x384e2138, 0x1e9b2c68, 0x01f5138c, 0x1aee8acc, 0x293e2c13, 0x28a6}}},
+		/*  9*pubkey[2]: */
+		{{{0x0e38eaf0, 0x391a8663, 0x25efeaea, 0x2c88a05f, 0x1d2479ad, 0x0a0febb1, 0x010ff629, 0x234652d0, 0x84d3}},
+		 {{0x08d6f8cd, 0x0db089be, 0x20c7f363, 0x1be40b4f, 0x2b92d7c2, 0x1f80b5d8, 0x08939c3c, 0x28a023e1, 0x92a0}}},
+		/* 11*pubkey[2]: */
+		{{{0x3384ab14, 0x3b4008f4, 0x141fafa7, 0x04e900eb, 0x06909911, 0x2fe8b57b, 0x2afeb9ab, 0x3cb9021c, 0x3be4}},
+		 {{0x20c6e0a3, 0x16b70b8a, 0x32da4cd5, 0x0958de70, 0x18cc04f9, 0x2691f52a, 0x23d8d904, 0x3c74d22e, 0x6139}}},
+		/* 13*pubkey[2]: */
+		{{{0x11040b0a, 0x01569f1e, 0x10e05cd8, 0x0141a5f1, 0x27b181de, 0x134bef12, 0x1e74fa7d, 0x3d20b1b8, 0x22e6}},
+		 {{0x3ab09d8f, 0x082d7835, 0x0b6ac913, 0x24b9c0d7, 0x04eca237, 0x0f69b9c6, 0x099a57c2, 0x3aca67a3, 0xcf7c}}},
+		/* 15*pubkey[2]: */
+		{{{0x16c7c7f0, 0x1877e159, 0x1cee94a5, 0x09a67431, 0x34538b97, 0x215311aa, 0x1813ff62, 0x0208459a, 0xb3dd}},
+		 {{0x03774170, 0x16ced8af, 0x1c090e7a, 0x28f1ea63, 0x0e5da942, 0x2e2e11cf, 0x3a0dd32f, 0x38f241e8, 0xedde}}},
+	},
+	{
+		/*  1*pubkey[3]: */
+		{{{0x31734997, 0x3273ae2e, 0x179fc6ee, 0x14bae2e4, 0x24034d02, 0x39322fdc, 0x1a2c89e8, 0x0b8712bd, 0x6d1d}},
+		 {{0x0b042ee4, 0x38f49b0b, 0x3c297e6f, 0x0b27fca6, 0x0b28949f, 0x3605b47a, 0x289a9867, 0x36c24a61, 0x3051}}},
+		/*  3*pubkey[3]: */
+		{{{0x15159ffa, 0x03cd618d, 0x381d1ec2, 0x0961af84, 0x3275615c, 0x2d6bc79d, 0x0720e84e, 0x1f957c72, 0x2058}},
+		 {{0x280ded5a, 0x10137b76, 0x10194fb9, 0x21d3b855, 0x043884a4, 0x008c02a4, 0x2a385681, 0x2cfd91c0, 0x243f}}},
+		/*  5*pubkey[3]: */
+		{{{0x2363c75e, 0x06619f27, 0x322f4df4, 0x05b35059, 0x39fddae8, 0x3246aace, 0x3164ee78, 0x3368362e, 0x1555}},
+		 {{0x0e7c3939, 0x09e17a72, 0x3dc80dd8, 0x2372367a, 0x105f6aaa, 0x15b33a04, 0x23e1930b, 0x33b91ad1, 0x8316}}},
+		/*  7*pubkey[3]: */
+		{{{0x377be13b, 0x1fd0d3c3, 0x23ce18a4, 0x0130713d, 0x34179ea0, 0x3415dc7f, 0x0a962e85, 0x11eaa44a, 0xd0b4}},
+		 {{0x2d4656f2, 0x3490a3d9, 0x013b9b44, 0x2b6726c0, 0x1660beff, 0x34bc8c94, 0x1aef62ef, 0x3f9bf25f, 0x7cfb}}},
+		/*  9*pubkey[3]: */
+		{{{0x1cd03daf, 0x30ddcdf0, 0x32e85cb0, 0x366b4c5b, 0x21433c96, 0x27fb8550, 0x14c4b686, 0x21f2b154, 0x2e58}},
+		 {{0x0b74519b, 0x3a028d43, 0x3bd05fbc, 0x11116ada, 0x040c1a3c, 0x0bc90981, 0x2fc3aae7, 0x06530e50, 0x7bc0}}},
+		/* 11*pubkey[3]: */
+		{{{0x3b307281, 0x264082fb, 0x3297648c, 0x33fcd645, 0x3fc45ba9, 0x2fd67268, 0x1716d288, 0x2b081aeb, 0x42cf}},
+		 {{0x122d2c14, 0x0a276d2a, 0x1e4532a6, 0x30ef9af3, 0x0ea10551, 0x279d4150, 0x2ee40c42, 0x2227bf4e, 0xfd13}}},
+		/* 13*pubkey[3]: */
+		{{{0x12ddfceb, 0x1628916b, 0x32930fb3, 0x24708e64, 0x007c6de6, 0x33d7d7ab, 0x28a30ce4, 0x2b04f8f9, 0xbc08}},
+		 {{0x265b11d8, 0x272ecad1, 0x1746c383, 0x3ed81297, 0x086d3a81, 0x0d3fd150, 0x36498722, 0x27f82705, 0x5687}}},
+		/* 15*pubkey[3]: */
+		{{{0x13ec5b95, 0x11648dad, 0x14f201dd, 0x0af68d8b, 0x1f2eeee9, 0x361af8d1, 0x278b09d2, 0x291b9859, 0xc011}},
+		 {{0x20e10527, 0x2694e018, 0x29d8bce8, 0x09afacf7, 0x321340de, 0x0cbffd25, 0x298cb514, 0x15072994, 0xa098}}},
+	},
+	{
+		/*  1*pubkey[4]: */
+		{{{0x0effc473, 0x2cf6da1f, 0x39736395, 0x0cccc606, 0x12af97a9, 0x14d1dd4e, 0x09d27a1d, 0x0ddd409e, 0x3bdf}},
+		 {{0x174ef403, 0x12848f77, 0x3171b02b, 0x024555f2, 0x08ab8b1f, 0x0a4e8a98, 0x034051e5, 0x29ed2579, 0xe513}}},
+		/*  3*pubkey[4]: */
+		{{{0x293ad738, 0x19bef376, 0x2ef0c104, 0x1fd45656, 0x279eaa9c, 0x17d86dc7, 0x112bc92c, 0x08b92896, 0x84e3}},
+		 {{0x0cab7b20, 0x0141df40, 0x27b59c31, 0x26cb5166, 0x2eb3b956, 0x027cafe8, 0x1ee3e411, 0x29738a81, 0xfe3d}}},
+		/*  5*pubkey[4]: */
+		{{{0x1c7475d2, 0x0d17d126, 0x33eaa0fb, 0x033882a2, 0x3404509a, 0x09f4f0b9, 0x2a2828e1, 0x16773930, 0x3b10}},
+		 {{0x148ba539, 0x3918b240, 0x235f4654, 0x25cfe3dd, 0x0fbaa681, 0x23856d1c, 0x3803fe91, 0x34f0f9dc, 0xbb20}}},
+		/*  7*pubkey[4]: */
+		{{{0x23200b77, 0x04898cb3, 0x2475f4ab, 0x390aaa84, 0x3f729400, 0x23b93bb3, 0x009b0931, 0x0330311e, 0x85fb}},
+		 {{0x07b52dea, 0x23c12e31, 0x1e7072b0, 0x14e1492f, 0x0d7cb08d, 0x1ebb8769, 0x05300cfe, 0x21134df4, 0x65f2}}},
+		/*  9*pubkey[4]: */
+		{{{0x3d81b95b, 0x12d80b94, 0x131a537d, 0x3d3a36bd, 0x0b61258c, 0x2a5bded9, 0x06693828, 0x3939b95f, 0x7446}},
+		 {{0x216273db, 0x053c2e8f, 0x3227f642, 0x352de4a2, 0x0ea506b3, 0x311a71f5, 0x2ad5d099, 0x36b4cea1, 0xb5c6}}},
+		/* 11*pubkey[4]: */
+		{{{0x1ae2da7f, 0x15978a52, 0x3495606b, 0x375d62cc, 0x0cbcd09a, 0x332cec9c, 0x0f25802e, 0x0d9f9ead, 0x7de9}},
+		 {{0x03a4a572, 0x3c1d721d, 0x0c0987f9, 0x3af01cd6, 0x124d1a60, 0x21836243, 0x112a0159, 0x3a4a2555, 0xf6fe}}},
+		/* 13*pubkey[4]: */
+		{{{0x1fcc1010, 0x2d90428b, 0x0fd8b0da, 0x0ab1bde1, 0x03637615, 0x261706e2, 0x3b5ebcfd, 0x2765b111, 0xe5de}},
+		 {{0x0f9ca012, 0x1afdcf6a, 0x3b686cf8, 0x1eef0c01, 0x019408bd, 0x29c8cd79, 0x31fafd40, 0x06ffc9e9, 0x4589}}},
+		/* 15*pubkey[4]: */
+		{{{0x27305759, 0x2aa9c154, 0x2eb61888, 0x20e41f11, 0x1be732a1, 0x1ed3e7ce, 0x1956f885, 0x297f9e79, 0x1e25}},
+		 {{0x2f90306b, 0x2dbfeb29, 0x0b834eba, 0x1d3507c6, 0x2cd92aab, 0x2b9e8dd8, 0x0c828aee, 0x1dace950, 0x209d}}},
+	},
+};
+
+static const curve_point generator_table[8] = {
+	/*  1*G: */
+	{{{0x16f81798, 0x27ca056c, 0x1ce28d95, 0x26ff36cb, 0x070b0702, 0x018a573a, 0x0bbac55a, 0x199fbe77, 0x79be}},
+	 {{0x3b10d4b8, 0x311f423f, 0x28554199, 0x05ed1229, 0x1108a8fd, 0x13eff038, 0x3c4655da, 0x369dc9a8, 0x483a}}},
+	/*  3*G: */
+	{{{0x3ce036f9, 0x1807c44e, 0x36f99b08, 0x0c721160, 0x1d5229b5, 0x113e17e2, 0x0c310493, 0x22806496, 0xf930}},
+	 {{0x04b8e672, 0x32e7f5d6, 0x0c2231b6, 0x002a664d, 0x37f35665, 0x0cdf98a8, 0x1e8140fe, 0x1ec3d8cb, 0x388f}}},
+	/*  5*G: */
+	{{{0x3240efe4, 0x2ea355a6, 0x0619ab7c, 0x22e12f77, 0x1c5128e8, 0x129c9429, 0x3209355b, 0x37934681, 0x2f8b}},
+	 {{0x26ac62d6, 0x32a1f4ea, 0x30d6840d, 0x2209c6ea, 0x09c426f7, 0x2ea7769b, 0x1e3d6d4d, 0x08898db9, 0xd8ac}}},
+	/*  7*G: */
+	{{{0x0ac4f9bc, 0x24af77b7, 0x330e39ce, 0x1066df80, 0x2a7a0e3d, 0x23cd97cb, 0x1b4eaa39, 0x3c191b97, 0x5cbd}},
+	 {{0x087264da, 0x142098a0, 0x3fde7b5a, 0x04f42e04, 0x1a54dba8, 0x1e35b618, 0x15960a31, 0x32902e89, 0x6aeb}}},
+	/*  9*G: */
+	{{{0x3c27ccbe, 0x0d7c4437, 0x057e714c, 0x25e5a5d3, 0x159abde0, 0x345e2a7d, 0x3f65309a, 0x2138bc31, 0xacd4}},
+	 {{0x064f9c37, 0x173098ab, 0x35f8e0f0, 0x3622290d, 0x3b61e9ad, 0x2025c5d8, 0x3d9fd643, 0x22486c29, 0xcc33}}},
+	/* 11*G: */
+	{{{0x1da008cb, 0x2fb05e25, 0x1c17891b, 0x126602f9, 0x065aac56, 0x1091adc3, 0x1411e5ef, 0x39fe162a, 0x774a}},
+	 {{0x0953c61b, 0x0075d327, 0x3f9d6a83, 0x0b6c78b7, 0x37b36537, 0x0f755b5e, 0x35e19024, 0x280cbada, 0xd984}}},
+	/* 13*G: */
+	{{{0x19405aa8, 0x3bb77e3c, 0x10e58cdd, 0x1d7ef198, 0x348651b0, 0x0748170d, 0x1288bc7d, 0x1cf0b65d, 0xf287}},
+	 {{0x1b03ed81, 0x26d72d4b, 0x21fa91f2, 0x0681b694, 0x0daf473a, 0x084bad97, 0x00a89758, 0x240ba362, 0x0ab0}}},
+	/* 15*G: */
+	{{{0x227e080e, 0x12b6f3e3, 0x085f79e4, 0x39651bcf, 0x1ff41131, 0x196b8c25, 0x3ea965a4, 0x1353df50, 0xd792}},
+	 {{0x36a26b58, 0x1413727f, 0x096d3a5c, 0x102bcaf6, 0x0c6defea, 0x10bb08a3, 0x072a6838, 0x0a1caa1b, 0x581e}}},
+};
@@ -0,0 +1,101 @@
+#!/usr/bin/env python
+"""
+Generates signatures_table.h: the firmware signing public keys and the odd
+multiples 1*P, 3*P, ..., 15*P of each key and of the generator, which the
+bootloader uses to verify the firmware signatures (see verify_digest_tables).
+The keys are read from firmware_sign.py.
+
+    ./signatures_table.py > signatures_table.h
+"""
+from __future__ import print_function
+import ast
+import binascii
+import os
+
+P = 0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f
+G = (0x79be667ef9dcbbac55a06295ce870b07029bfcdb2dce28d959f2815b16f81798,
+     0x483ada7726a3c4655da4fbfc0e1108a8fd17b448a68554199c47d08ffb10d4b8)
+MULTIPLES = 8
+
+
+def load_pubkeys():
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'firmware_sign.py')
+    with open(path) as f:
+        tree = ast.parse(f.read())
+    for node in tree.body:
+        if isinstance(node, ast.Assign) and getattr(node.targets[0], 'id', None) == 'pubkeys':
+            pubkeys = ast.literal_eval(node.value)
+            return [binascii.unhexlify(pubkeys[i]) for i in sorted(pubkeys)]
+    raise Exception('No pubkeys in %s' % path)
+
+
+def decompress(pubkey):
+    x = int(binascii.hexlify(pubkey[1:]), 16)
+    y = pow((x * x * x + 7) % P, (P + 1) // 4, P)
+    if y * y % P != (x * x * x + 7) % P:
+        raise Exception('%s is not on the curve' % binascii.hexlify(pubkey))
+    if y % 2 != pubkey[0] % 2:
+        y = P - y
+    return x, y
+
+
+def add(a, b):
+    if a == b:
+        lam = 3 * a[0] * a[0] * pow(2 * a[1], P - 2, P)
+    else:
+        lam = (b[1] - a[1]) * pow(b[0] - a[0], P - 2, P)
+    x = (lam * lam - a[0] - b[0]) % P
+    return x, (lam * (a[0] - x) - a[1]) % P
+
+
+def odd_multiples(p):
+    twice = add(p, p)
+    table = [p]
+    for _ in range(MULTIPLES - 1):
+        table.append(add(table[-1], twice))
+    return table
+
+
+def limbs(v):
+    # bignum256: eight 30 bit limbs and the top 16 bits
+    return [(v >> (30 * i)) & 0x3fffffff for i in range(8)] + [v >> 240]
+
+
+def format_bignum(v):
+    # same layout as secp256k1.table
+    l = limbs(v)
+    return ', '.join(['0x%08x' % x for x in l[:8]] + ['0x%04x' % l[8]])
+
+
+def print_table(table, name, indent):
+    for i, (x, y) in enumerate(table):
+        print('%s/* %2d*%s: */' % (indent, 2 * i + 1, name))
+        print('%s{{{%s}},' % (indent, format_bignum(x)))
+        print('%s {{%s}}},' % (indent, format_bignum(y)))
+
+
+def main():
+    pubkeys = load_pubkeys()
+    print('// generated by signatures_table.py, do not edit')
+    print()
+    print('#define PUBKEYS %d' % len(pubkeys))
+    print()
+    print('static const uint8_t * const pubkey[PUBKEYS] = {')
+    for pubkey in pubkeys:
+        print('\t(const uint8_t *)"%s",' % ''.join('\\x%02x' % b for b in bytearray(pubkey)))
+    print('};')
+    print()
+    print('static const curve_point pubkey_table[PUBKEYS][%d] = {' % MULTIPLES)
+    for i, pubkey in enumerate(pubkeys):
+        print('\t{')
+        print_table(odd_multiples(decompress(pubkey)), 'pubkey[%d]' % i, '\t\t')
+        print('\t},')
+    print('};')
+    print()
+    print('static const curve_point generator_table[%d] = {' % MULTIPLES)
+    print_table(odd_multiples(G), 'G', '\t')
+    print('};')
+
+
+if __name__ == '__main__':
+    main()
@@ -37,8 +37,6 @@
 #include "secp256k1.h"
 #include "memzero.h"
 
-#define FIRMWARE_MAGIC "SKY1"
-
 #define ENDPOINT_ADDRESS_IN         (0x81)
 #define ENDPOINT_ADDRESS_OUT        (0x01)
 
@@ -189,6 +187,28 @@ static uint32_t msg_size = 0;
 
 static uint8_t meta_backup[FLASH_META_LEN];
 
+/* sha256 of the code, computed while the firmware is uploaded.
+ */
+static SHA256_CTX flash_hash_ctx;
+static uint8_t flash_hash[32];
+static bool flash_readback_ok;
+
+/* FIRMWARE_MAGIC_SECTORS images: the code starts after the sector hashes,
+ * which tell the sectors to erase and write, and the sha256 above is of
+ * the code in the current sector.
+ */
+static bool flash_sectors;
+static uint32_t flash_code_start;
+static uint8_t flash_sector_hashes[FLASH_CODE_SECTORS][32];
+static bool flash_sector_write[FLASH_CODE_SECTORS];
+static int flash_sector;
+static bool flash_sectors_ok;
+
+/* The code sectors were erased by FirmwareErase, which is done unless the
+ * host announces a SKY2 image with FirmwareErase.sectors.
+ */
+static bool flash_code_erased;
+
 static void send_msg_success(usbd_device *dev)
 {
 	// response: Success message (id 2), payload len 0
@@ -291,6 +311,126 @@ static void send_msg_buttonrequest_firmwarecheck(usbd_device *dev)
 		, 64) != 64) {}
 }
 
+static void erase_code_sectors(void)
+{
+	for (int i = FLASH_CODE_SECTOR_FIRST; i <= FLASH_CODE_SECTOR_LAST; i++) {
+		layoutProgress("ERASING ... Please wait", 1000 * (i - FLASH_META_SECTOR_FIRST) / (FLASH_CODE_SECTOR_LAST - FLASH_META_SECTOR_FIRST));
+		flash_erase_sector(i, FLASH_CR_PROGRAM_X32);
+	}
+	layoutProgress("INSTALLING ... Please wait", 0);
+}
+
+// FirmwareErase.sectors (field 2) from the payload of the first packet
+static bool firmware_erase_sectors(uint8_t *buf, uint32_t size)
+{
+	uint8_t *p = buf + 9;
+	const uint8_t *end = buf + 9 + (size < 64 - 9 ? size : 64 - 9);
+	bool sectors = false;
+	while (p < end) {
+		const uint32_t tag = readprotobufint(&p);
+		if ((tag & 7) != 0) {	// only varint fields
+			break;
+		}
+		const uint32_t value = readprotobufint(&p);
+		if ((tag >> 3) == 2) {
+			sectors = value != 0;
+		}
+	}
+	return sectors;
+}
+
+// whether flash from start to end is erased
+static bool flash_erased(uint32_t start, uint32_t end)
+{
+	for (uint32_t addr = start; addr < end; addr += 4) {
+		if (*(const uint32_t *)addr != 0xffffffff) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// erase the code sectors whose installed code differs from the uploaded hash,
+// and those holding anything past the end of the new code
+static void erase_changed_sectors(void)
+{
+	if (flash_code_erased) {
+		memset(flash_sector_write, true, sizeof(flash_sector_write));
+		return;
+	}
+	const uint32_t codelen = *((const uint32_t *)FLASH_META_CODELEN);
+	if (codelen != flash_len - flash_code_start) {
+		// the hashes cannot be compared, the signatures will not match either
+		memset(flash_sector_write, true, sizeof(flash_sector_write));
+		erase_code_sectors();
+		return;
+	}
+	uint8_t installed[FLASH_CODE_SECTORS][32];
+	signatures_sector_hashes(codelen, installed);
+	const uint32_t code_end = FLASH_APP_START + codelen;
+	for (int i = 0; i < FLASH_CODE_SECTORS; i++) {
+		const uint32_t start = FLASH_SECTOR_START(FLASH_CODE_SECTOR_FIRST + i);
+		const uint32_t end = FLASH_SECTOR_START(FLASH_CODE_SECTOR_FIRST + i + 1);
+		flash_sector_write[i] = start >= code_end
+			|| memcmp(installed[i], flash_sector_hashes[i], 32) != 0
+			|| !flash_erased(code_end < end ? code_end : end, end);
+		if (flash_sector_write[i]) {
+			layoutProgress("ERASING ... Please wait", 1000 * i / FLASH_CODE_SECTORS);
+			flash_erase_sector(FLASH_CODE_SECTOR_FIRST + i, FLASH_CR_PROGRAM_X32);
+		}
+	}
+	layoutProgress("INSTALLING ... Please wait", 0);
+}
+
+// compare the sha256 of the uploaded code of a sector with its hash
+static void flash_sector_done(void)
+{
+	uint8_t hash[32];
+	sha256_Final(&flash_hash_ctx, hash);
+	if (memcmp(hash, flash_sector_hashes[flash_sector], 32) != 0) {
+		flash_sectors_ok = false;
+	}
+	flash_sector++;
+	sha256_Init(&flash_hash_ctx);
+}
+
+static void flash_upload_word(uint32_t word)
+{
+	uint32_t addr;
+	if (flash_pos < FLASH_META_DESC_LEN) {
+		addr = FLASH_META_START + flash_pos;			// the first 256 bytes of firmware is metadata descriptor
+	} else if (flash_pos < flash_code_start) {
+		// sector hashes, kept in RAM
+		memcpy((uint8_t *)flash_sector_hashes + (flash_pos - FLASH_META_DESC_LEN), &word, sizeof(word));
+		flash_pos += 4;
+		if (flash_pos == flash_code_start) {
+			erase_changed_sectors();
+		}
+		return;
+	} else {
+		addr = FLASH_APP_START + (flash_pos - flash_code_start);	// the rest is code
+		if (flash_sectors) {
+			if (addr == FLASH_SECTOR_START(FLASH_CODE_SECTOR_FIRST + flash_sector + 1)) {
+				flash_sector_done();
+			}
+			sha256_Update(&flash_hash_ctx, (const uint8_t *)&word, sizeof(word));
+			if (!flash_sector_write[flash_sector]) {
+				// unchanged, the hash confirms the installed code
+				flash_pos += 4;
+				return;
+			}
+		} else {
+			sha256_Update(&flash_hash_ctx, (const uint8_t *)&word, sizeof(word));
+		}
+	}
+	flash_program_word(addr, word);
+	// the hash is of what was sent, check that it is what was written
+	if (*(const volatile uint32_t *)addr != word) {
+		flash_readback_ok = false;
+	}
+	flash_pos += 4;
+}
+
 static void erase_metadata_sectors(void)
 {
 	flash_unlock();
@@ -488,17 +628,14 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 				flash_wait_for_last_operation();
 				flash_clear_status_flags();
 				flash_unlock();
-				// erase metadata area
-				for (int i = FLASH_META_SECTOR_FIRST; i <= FLASH_META_SECTOR_LAST; i++) {
+				// erase metadata area, and the code area unless a SKY2 image
+				// tells which sectors change, see erase_changed_sectors
+				flash_code_erased = !firmware_erase_sectors(buf, msg_size);
+				const int last = flash_code_erased ? FLASH_CODE_SECTOR_LAST : FLASH_META_SECTOR_LAST;
+				for (int i = FLASH_META_SECTOR_FIRST; i <= last; i++) {
 					layoutProgress("ERASING ... Please wait", 1000 * (i - FLASH_META_SECTOR_FIRST) / (FLASH_CODE_SECTOR_LAST - FLASH_META_SECTOR_FIRST));
 					flash_erase_sector(i, FLASH_CR_PROGRAM_X32);
 				}
-				// erase code area
-				for (int i = FLASH_CODE_SECTOR_FIRST; i <= FLASH_CODE_SECTOR_LAST; i++) {
-					layoutProgress("ERASING ... Please wait", 1000 * (i - FLASH_META_SECTOR_FIRST) / (FLASH_CODE_SECTOR_LAST - FLASH_META_SECTOR_FIRST));
-					flash_erase_sector(i, FLASH_CR_PROGRAM_X32);
-				}
-				layoutProgress("INSTALLING ... Please wait", 0);
 				flash_wait_for_last_operation();
 				flash_lock();
 
@@ -538,31 +675,40 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 			// read payload length
 			uint8_t *p = buf + 10;
 			flash_len = readprotobufint(&p);
-			if (flash_len > FLASH_TOTAL_SIZE + FLASH_META_DESC_LEN - (FLASH_APP_START - FLASH_ORIGIN)) { // firmware is too big
+			// check firmware magic
+			flash_sectors = memcmp(p, FIRMWARE_MAGIC_SECTORS, 4) == 0;
+			flash_code_start = FLASH_META_DESC_LEN + (flash_sectors ? sizeof(flash_sector_hashes) : 0);
+			if (!flash_sectors && memcmp(p, FIRMWARE_MAGIC, 4) != 0) {
 				send_msg_failure(dev);
 				flash_state = STATE_END;
-				layoutDialog(&bmp_icon_error, NULL, NULL, NULL, "Firmware is too big.", NULL, "Get official firmware", "github.com/skycoin/hardware-wallet", NULL, NULL);
+				layoutDialog(&bmp_icon_error, NULL, NULL, NULL, "Wrong firmware header.", NULL, "Get official firmware", "github.com/skycoin/hardware-wallet", NULL, NULL);
 				return;
 			}
-			// check firmware magic
-			if (memcmp(p, FIRMWARE_MAGIC, 4) != 0) {
+			if (flash_len < flash_code_start || flash_len - flash_code_start > FLASH_TOTAL_SIZE - (FLASH_APP_START - FLASH_ORIGIN)) { // firmware is too big
 				send_msg_failure(dev);
 				flash_state = STATE_END;
-				layoutDialog(&bmp_icon_error, NULL, NULL, NULL, "Wrong firmware header.", NULL, "Get official firmware", "github.com/skycoin/hardware-wallet", NULL, NULL);
+				layoutDialog(&bmp_icon_error, NULL, NULL, NULL, "Firmware is too big.", NULL, "Get official firmware", "github.com/skycoin/hardware-wallet", NULL, NULL);
 				return;
 			}
 			flash_state = STATE_FLASHING;
 			p += 4;         // Don't flash firmware header yet.
 			flash_pos = 4;
 			wi = 0;
+			sha256_Init(&flash_hash_ctx);
+			flash_readback_ok = true;
+			flash_sector = 0;
+			flash_sectors_ok = true;
 			flash_unlock();
+			if (!flash_sectors && !flash_code_erased) {
+				// announced as SKY2 but is not
+				erase_code_sectors();
+			}
 			while (p < buf + 64) {
 				towrite[wi] = *p;
 				wi++;
 				if (wi == 4) {
 					const uint32_t *w = (uint32_t *)towrite;
-					flash_program_word(FLASH_META_START + flash_pos, *w);
-					flash_pos += 4;
+					flash_upload_word(*w);
 					wi = 0;
 				}
 				p++;
@@ -591,12 +737,7 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 			wi++;
 			if (wi == 4) {
 				const uint32_t *w = (const uint32_t *)towrite;
-				if (flash_pos < FLASH_META_DESC_LEN) {
-					flash_program_word(FLASH_META_START + flash_pos, *w);			// the first 256 bytes of firmware is metadata descriptor
-				} else {
-					flash_program_word(FLASH_APP_START + (flash_pos - FLASH_META_DESC_LEN), *w);	// the rest is code
-				}
-				flash_pos += 4;
+				flash_upload_word(*w);
 				wi = 0;
 			}
 			p++;
@@ -604,6 +745,20 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 		flash_lock();
 		// flashing done
 		if (flash_pos == flash_len) {
+			if (flash_sectors) {
+				while (flash_sector < FLASH_CODE_SECTORS) {
+					flash_sector_done();
+				}
+				signatures_merkle_root(flash_sector_hashes, flash_hash);
+			} else {
+				sha256_Final(&flash_hash_ctx, flash_hash);
+			}
+			if (!flash_readback_ok || !flash_sectors_ok) {
+				send_msg_failure(dev);
+				flash_state = STATE_END;
+				layoutDialog(&bmp_icon_error, NULL, NULL, NULL, "Error installing ", "firmware.", NULL, "Unplug your Skycoin wallet", "and try again.", NULL);
+				return;
+			}
 			flash_state = STATE_CHECK;
 			if (!brand_new_firmware) {
 				send_msg_buttonrequest_firmwarecheck(dev);
@@ -620,9 +775,7 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 			if (msg_id != 0x001B) {	// ButtonAck message (id 27)
 				return;
 			}
-			uint8_t hash[32];
-			sha256_Raw((unsigned char *)FLASH_APP_START, flash_len - FLASH_META_DESC_LEN, hash);
-			layoutFirmwareHash(hash);
+			layoutFirmwareHash(flash_hash);
 			do {
 				delay(100000);
 				buttonUpdate();
@@ -638,6 +791,8 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 		// 1) old firmware was unsigned
 		// 2) firmware restore flag isn't set
 		// 3) signatures are not ok
+		// the magic is not written yet, so signatures_ok() fails here and
+		// the storage is always wiped, the hash of the upload is not used
 		if (brand_new_firmware || old_was_unsigned || (flags & 0x01) == 0 || SIG_OK != signatures_ok(NULL)) {
 			memzero(meta_backup, sizeof(meta_backup));
 		}
@@ -645,7 +800,7 @@ static void hid_rx_callback(usbd_device *dev, uint8_t ep)
 		memcpy(meta_backup, (void *)FLASH_META_START, FLASH_META_DESC_LEN);
 		// write MAGIC in header only when hash was confirmed
 		if (hash_check_ok) {
-			memcpy(meta_backup, FIRMWARE_MAGIC, 4);
+			memcpy(meta_backup, flash_sectors ? FIRMWARE_MAGIC_SECTORS : FIRMWARE_MAGIC, 4);
 		} else {
 			memzero(meta_backup, 4);
 		}
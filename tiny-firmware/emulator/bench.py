@@ -0,0 +1,245 @@
+#!/usr/bin/env python3
+"""
+End-to-end protocol benchmark against the emulator.
+
+Starts a DEBUG_LINK emulator with in-memory flash, provisions it with
+LoadDevice, then sends a weighted random mix of requests over the UDP
+transport, confirming every button request through the debug link. Prints
+messages/s and latency percentiles per request as JSON.
+"""
+import argparse
+import json
+import os
+import random
+import socket
+import struct
+import subprocess
+import sys
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(HERE, '..', 'protob'))
+
+import messages_pb2 as messages  # noqa: E402
+
+MNEMONIC = 'cloud flower upset remain green metal below cup stem infant art thank'
+MESSAGE = 'Hello World!'
+
+REPORT_SIZE = 64
+DEFAULT_MIX = 'GetFeatures=1,Ping=1,SkycoinAddress=2,SkycoinSignMessage=1,SkycoinCheckMessageSignature=1'
+
+
+class Transport(object):
+    def __init__(self, port, timeout):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(timeout)
+        self.addr = ('127.0.0.1', port)
+
+    def ping(self):
+        timeout = self.sock.gettimeout()
+        self.sock.settimeout(0.1)
+        self.sock.sendto(b'PINGPING', self.addr)
+        try:
+            return self.sock.recvfrom(REPORT_SIZE)[0] == b'PONGPONG'
+        except socket.timeout:
+            return False
+        finally:
+            self.sock.settimeout(timeout)
+
+    def write(self, msg):
+        msg_id = messages.MessageType.Value('MessageType_' + msg.DESCRIPTOR.name)
+        data = msg.SerializeToString()
+        data = b'##' + struct.pack('>HI', msg_id, len(data)) + data
+        while data:
+            report = b'?' + data[:REPORT_SIZE - 1]
+            self.sock.sendto(report.ljust(REPORT_SIZE, b'\0'), self.addr)
+            data = data[REPORT_SIZE - 1:]
+
+    def read(self):
+        report = self.sock.recvfrom(REPORT_SIZE)[0]
+        if report[:3] != b'?##':
+            raise Exception('Unexpected report %r' % report[:9])
+        msg_id, size = struct.unpack('>HI', report[3:9])
+        data = report[9:]
+        while len(data) < size:
+            data += self.sock.recvfrom(REPORT_SIZE)[0][1:]
+        name = messages.MessageType.Name(msg_id)[len('MessageType_'):]
+        msg = getattr(messages, name)()
+        msg.ParseFromString(data[:size])
+        return msg
+
+
+class Device(object):
+    def __init__(self, port, timeout):
+        self.main = Transport(port, timeout)
+        self.debug = Transport(port + 1, timeout)
+
+    def wait(self, timeout):
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            if self.main.ping():
+                return
+        raise Exception('Emulator does not answer on %s:%d' % self.main.addr)
+
+    def call(self, msg):
+        self.main.write(msg)
+        resp = self.main.read()
+        while resp.DESCRIPTOR.name in ('ButtonRequest', 'Progress'):
+            if resp.DESCRIPTOR.name == 'ButtonRequest':
+                self.main.write(messages.ButtonAck())
+                self.debug.write(messages.DebugLinkDecision(yes_no=True))
+            resp = self.main.read()
+        if resp.DESCRIPTOR.name == 'Failure':
+            raise Exception('%s failed: %s' % (msg.DESCRIPTOR.name, resp.message))
+        return resp
+
+
+def parse_list(value):
+    return [int(v) for v in value.split(',')]
+
+
+def parse_mix(value):
+    mix = []
+    for item in value.split(','):
+        name, _, weight = item.partition('=')
+        mix.append((name, int(weight or 1)))
+    return mix
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Benchmark the emulator over its UDP transport.')
+    parser.add_argument('-e', '--emulator', default=os.path.join(HERE, '..', 'skycoin-emulator'), help='Emulator binary, built with DEBUG_LINK=1 (use --no-start to benchmark a running one)')
+    parser.add_argument('--no-start', dest='start', action='store_false', help='Do not start an emulator')
+    parser.add_argument('-p', '--port', type=int, default=21324, help='Emulator main UDP port')
+    parser.add_argument('-n', '--count', type=int, default=1000, help='Number of requests')
+    parser.add_argument('-m', '--mix', default=DEFAULT_MIX, help='Weighted requests (default: %(default)s)')
+    parser.add_argument('--address-n', type=parse_list, default=[1, 10], help='SkycoinAddress address_n values')
+    parser.add_argument('--start-index', type=parse_list, default=[0, 50], help='SkycoinAddress start_index values')
+    parser.add_argument('--sign-index', type=parse_list, default=[1], help='SkycoinSignMessage address_n values')
+    parser.add_argument('--seed', type=int, default=0, help='Seed of the request mix')
+    parser.add_argument('-o', '--output', help='Write the JSON results to a file instead of stdout')
+    return parser.parse_args()
+
+
+def requests(args, address, signature):
+    builders = {
+        'GetFeatures': lambda rng: ({}, messages.GetFeatures()),
+        'Ping': lambda rng: ({}, messages.Ping(message=MESSAGE)),
+        'SkycoinAddress': lambda rng: skycoin_address(rng, args),
+        'SkycoinSignMessage': lambda rng: skycoin_sign_message(rng, args),
+        'SkycoinCheckMessageSignature': lambda rng: ({}, messages.SkycoinCheckMessageSignature(address=address, message=MESSAGE, signature=signature)),
+    }
+    mix = parse_mix(args.mix)
+    for name, _ in mix:
+        if name not in builders:
+            raise Exception('Unknown request %s (%s)' % (name, ', '.join(sorted(builders))))
+
+    rng = random.Random(args.seed)
+    names = [name for name, _ in mix]
+    weights = [weight for _, weight in mix]
+    for _ in range(args.count):
+        name = rng.choices(names, weights)[0]
+        params, msg = builders[name](rng)
+        yield name, params, msg
+
+
+def skycoin_address(rng, args):
+    params = {'address_n': rng.choice(args.address_n), 'start_index': rng.choice(args.start_index)}
+    return params, messages.SkycoinAddress(**params)
+
+
+def skycoin_sign_message(rng, args):
+    params = {'address_n': rng.choice(args.sign_index)}
+    return params, messages.SkycoinSignMessage(message=MESSAGE, **params)
+
+
+def percentile(values, p):
+    # nearest rank
+    values = sorted(values)
+    rank = max(1, int(-(-p * len(values) // 100)))
+    return values[rank - 1]
+
+
+def summarize(samples):
+    results = []
+    for (name, params), latencies in sorted(samples.items()):
+        busy = sum(latencies)
+        result = {'message': name}
+        result.update(dict(params))
+        result.update({
+            'count': len(latencies),
+            'messages_per_s': round(len(latencies) / busy, 2) if busy else None,
+            'mean_ms': round(busy * 1000 / len(latencies), 3),
+            'p50_ms': round(percentile(latencies, 50) * 1000, 3),
+            'p99_ms': round(percentile(latencies, 99) * 1000, 3),
+        })
+        results.append(result)
+    return results
+
+
+def provision(device):
+    device.call(messages.WipeDevice())
+    device.call(messages.LoadDevice(mnemonic=MNEMONIC))
+    address = device.call(messages.SkycoinAddress(address_n=1)).addresses[0]
+    signature = device.call(messages.SkycoinSignMessage(address_n=0, message=MESSAGE)).signed_message
+    check = messages.SkycoinCheckMessageSignature(address=address, message=MESSAGE, signature=signature)
+    if device.call(check).message != address:
+        raise Exception('Signature of %s does not verify' % address)
+    features = device.call(messages.GetFeatures())
+    version = '%d.%d.%d' % (features.major_version, features.minor_version, features.patch_version)
+    return version, address, signature
+
+
+def run(args, device):
+    version, address, signature = provision(device)
+
+    samples = {}
+    start = time.perf_counter()
+    for name, params, msg in requests(args, address, signature):
+        sent = time.perf_counter()
+        device.call(msg)
+        key = (name, tuple(sorted(params.items())))
+        samples.setdefault(key, []).append(time.perf_counter() - sent)
+    elapsed = time.perf_counter() - start
+
+    return {
+        'firmware_version': version,
+        'transport': 'udp',
+        'count': args.count,
+        'mix': args.mix,
+        'seed': args.seed,
+        'elapsed_s': round(elapsed, 3),
+        'messages_per_s': round(args.count / elapsed, 2),
+        'results': summarize(samples),
+    }
+
+
+def main(args):
+    emulator = None
+    if args.start:
+        env = dict(os.environ)
+        env.setdefault('TREZOR_EMULATOR_FLASH', 'memory')
+        env.setdefault('TREZOR_EMULATOR_CLOCK', 'virtual')
+        env.setdefault('TREZOR_EMULATOR_SEED', 'bench')
+        with open(os.devnull, 'w') as devnull:
+            emulator = subprocess.Popen([os.path.abspath(args.emulator)], env=env, stdout=devnull, stderr=devnull)
+
+    try:
+        device = Device(args.port, 60)
+        device.wait(10)
+        report = run(args, device)
+    finally:
+        if emulator:
+            emulator.terminate()
+            emulator.wait()
+
+    output = json.dumps(report, indent=2, sort_keys=True)
+    if args.output:
+        with open(args.output, 'w') as f:
+            f.write(output + '\n')
+    else:
+        print(output)
+
+
+if __name__ == '__main__':
+    main(parse_args())
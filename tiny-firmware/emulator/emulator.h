@@ -22,18 +22,40 @@
 
 #if EMULATOR
 
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 #if !defined(__APPLE__) && !defined(TARGET_OS_MAC)
 #include "strl.h"  // NOTE(denisacostaq@gmail.com): This file is not required by BSD family(Darwin)
 #endif  // !defined(__APPLE__) && !defined(TARGET_OS_MAC)
 
+// largest frame emulatorSocketRead can return: '?' + header + payload
+#define EMULATOR_FRAME_MAX (16 * 1024)
+
+extern unsigned int emulator_device_index;
+extern unsigned int emulator_device_count;
+
 void emulatorPoll(void);
 void emulatorRandom(void *buffer, size_t size);
+void emulatorRandomSeed(const uint8_t *seed, size_t len);
+
+void emulatorClockSetVirtual(bool enable);
+bool emulatorClockIsVirtual(void);
+void emulatorClockAdvance(uint32_t ms);
+
+// overrides TREZOR_EMULATOR_FLASH before setup(), NULL keeps flash in memory
+void emulatorSetFlashImage(const char *path);
+void emulatorFlashSync(void);
+void emulatorFlashSnapshot(void);
+bool emulatorFlashRestore(void);
+bool emulatorFlashPoll(void);
 
 void emulatorSocketInit(void);
+// iface 0 is the main UDP port, 1 the debug port and 2 the stream transport
 size_t emulatorSocketRead(int *iface, void *buffer, size_t size);
 size_t emulatorSocketWrite(int iface, const void *buffer, size_t size);
+void emulatorSocketWait(uint32_t timeout);
 
 #endif  // EMULATOR
 
@@ -90,19 +90,37 @@ void oledRefresh(void) {
 
 	static uint32_t data[OLED_HEIGHT][OLED_WIDTH];
 
-	for (size_t i = 0; i < OLED_BUFSIZE; i++) {
-		int x = (OLED_BUFSIZE - 1 - i) % OLED_WIDTH;
-		int y = (OLED_BUFSIZE - 1 - i) / OLED_WIDTH * 8 + 7;
-
-		for (uint8_t shift = 0; shift < 8; shift++, y--) {
-			bool set = (buffer[i] >> shift) & 1;
-			data[y][x] = set ? 0xFFFFFFFF : 0xFF000000;
+	uint8_t first[OLED_HEIGHT / 8], last[OLED_HEIGHT / 8];
+	if (oledTakeDirty(first, last)) {
+		/* Convert the changed bytes, the buffer is upside down */
+		SDL_Rect rect = {OLED_WIDTH, OLED_HEIGHT, 0, 0};
+		int x2 = 0, y2 = 0;
+		for (int page = 0; page < OLED_HEIGHT / 8; page++) {
+			for (int column = first[page]; column <= last[page]; column++) {
+				size_t i = page * OLED_WIDTH + column;
+				int x = (OLED_BUFSIZE - 1 - i) % OLED_WIDTH;
+				int y = (OLED_BUFSIZE - 1 - i) / OLED_WIDTH * 8 + 7;
+
+				for (uint8_t shift = 0; shift < 8; shift++, y--) {
+					bool set = (buffer[i] >> shift) & 1;
+					data[y][x] = set ? 0xFFFFFFFF : 0xFF000000;
+				}
+			}
+			if (first[page] <= last[page]) {
+				int y = (OLED_HEIGHT / 8 - 1 - page) * 8;
+				if (OLED_WIDTH - 1 - last[page] < rect.x) rect.x = OLED_WIDTH - 1 - last[page];
+				if (OLED_WIDTH - first[page] > x2) x2 = OLED_WIDTH - first[page];
+				if (y < rect.y) rect.y = y;
+				if (y + 8 > y2) y2 = y + 8;
+			}
 		}
-	}
+		rect.w = x2 - rect.x;
+		rect.h = y2 - rect.y;
 
-	SDL_UpdateTexture(texture, NULL, data, OLED_WIDTH * sizeof(uint32_t));
-	SDL_RenderCopy(renderer, texture, NULL, NULL);
-	SDL_RenderPresent(renderer);
+		SDL_UpdateTexture(texture, &rect, &data[rect.y][rect.x], OLED_WIDTH * sizeof(uint32_t));
+		SDL_RenderCopy(renderer, texture, NULL, NULL);
+		SDL_RenderPresent(renderer);
+	}
 
 	/* Return it back */
 	oledInvertDebugLink();
@@ -115,6 +133,11 @@ void emulatorPoll(void) {
 		if (event.type == SDL_QUIT) {
 			exit(0);
 		}
+		/* Nothing is presented while the screen does not change */
+		if (event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_EXPOSED) {
+			SDL_RenderCopy(renderer, texture, NULL, NULL);
+			SDL_RenderPresent(renderer);
+		}
 	}
 }
 
@@ -17,16 +17,114 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <string.h>
+
 #include "rng.h"
+#include "memzero.h"
+#include "sha2.h"
+
+/*
+ * ChaCha20 based DRBG. Output is produced DRBG_BLOCKS blocks at a time and
+ * the first 32 bytes of every refill become the next key (fast key erasure),
+ * so /dev/urandom is read once for the seed instead of once per word.
+ */
+#define DRBG_BLOCKS 16
+
+#define ROTL32(v, n) (((v) << (n)) | ((v) >> (32 - (n))))
+
+#define QUARTERROUND(a, b, c, d) \
+	a += b; d ^= a; d = ROTL32(d, 16); \
+	c += d; b ^= c; b = ROTL32(b, 12); \
+	a += b; d ^= a; d = ROTL32(d, 8); \
+	c += d; b ^= c; b = ROTL32(b, 7);
+
+static uint32_t drbg_key[8];
+static uint32_t drbg_buf[DRBG_BLOCKS * 16];
+static size_t drbg_pos = sizeof(drbg_buf);
+static bool drbg_seeded = false;
+
+static void chacha20_block(const uint32_t key[8], uint32_t counter, uint32_t out[16]) {
+	const uint32_t in[16] = {
+		0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+		key[0], key[1], key[2], key[3], key[4], key[5], key[6], key[7],
+		counter, 0, 0, 0,
+	};
+	uint32_t *x = out;
+
+	memcpy(x, in, sizeof(in));
+	for (int i = 0; i < 10; i++) {
+		QUARTERROUND(x[0], x[4], x[8], x[12]);
+		QUARTERROUND(x[1], x[5], x[9], x[13]);
+		QUARTERROUND(x[2], x[6], x[10], x[14]);
+		QUARTERROUND(x[3], x[7], x[11], x[15]);
+		QUARTERROUND(x[0], x[5], x[10], x[15]);
+		QUARTERROUND(x[1], x[6], x[11], x[12]);
+		QUARTERROUND(x[2], x[7], x[8], x[13]);
+		QUARTERROUND(x[3], x[4], x[9], x[14]);
+	}
+	for (int i = 0; i < 16; i++) {
+		x[i] += in[i];
+	}
+}
+
+static void drbg_refill(void) {
+	if (!drbg_seeded) {
+		emulatorRandom(drbg_key, sizeof(drbg_key));
+		drbg_seeded = true;
+	}
+
+	for (uint32_t i = 0; i < DRBG_BLOCKS; i++) {
+		chacha20_block(drbg_key, i, drbg_buf + i * 16);
+	}
+
+	memcpy(drbg_key, drbg_buf, sizeof(drbg_key));
+	memzero(drbg_buf, sizeof(drbg_key));
+	drbg_pos = sizeof(drbg_key);
+}
+
+static void drbg_read(uint8_t *buf, size_t len) {
+	while (len > 0) {
+		if (drbg_pos == sizeof(drbg_buf)) {
+			drbg_refill();
+		}
+
+		size_t n = sizeof(drbg_buf) - drbg_pos;
+		if (n > len) {
+			n = len;
+		}
+		memcpy(buf, (uint8_t *) drbg_buf + drbg_pos, n);
+		memzero((uint8_t *) drbg_buf + drbg_pos, n);
+		drbg_pos += n;
+		buf += n;
+		len -= n;
+	}
+}
+
+void emulatorRandomSeed(const uint8_t *seed, size_t len) {
+	if (len == 0) {
+		// back to a fresh seed from /dev/urandom
+		drbg_seeded = false;
+	} else {
+		sha256_Raw(seed, len, (uint8_t *) drbg_key);
+		drbg_seeded = true;
+	}
+
+	memzero(drbg_buf, sizeof(drbg_buf));
+	drbg_pos = sizeof(drbg_buf);
+}
 
 uint32_t random32(void) {
 	static uint32_t last = 0;
 	uint32_t new;
 
 	do {
-		emulatorRandom(&new, sizeof(new));
+		drbg_read((uint8_t *) &new, sizeof(new));
 	} while (last == new);
 
 	last = new;
 	return new;
 }
+
+void random_buffer(uint8_t *buf, size_t len) {
+	drbg_read(buf, len);
+}
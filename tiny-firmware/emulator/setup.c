@@ -19,10 +19,17 @@
 
 #include <errno.h>
 #include <fcntl.h>
+#include <signal.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <sys/wait.h>
 #include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
 
 #include <libopencm3/stm32/flash.h>
 
@@ -33,18 +40,36 @@
 #include "timer.h"
 
 #define EMULATOR_FLASH_FILE "emulator.img"
+#define EMULATOR_FLASH_FILE_N "emulator-%u.img"
+
+#define ENV_EMULATOR_FLASH "TREZOR_EMULATOR_FLASH"
+#define ENV_EMULATOR_DEVICES "TREZOR_EMULATOR_DEVICES"
+#define ENV_EMULATOR_SEED "TREZOR_EMULATOR_SEED"
+#define EMULATOR_MAX_DEVICES 512
 
 uint8_t *emulator_flash_base = NULL;
+static bool emulator_flash_file = true;
+static bool emulator_flash_image_set = false;
+static const char *emulator_flash_image = NULL;
+static uint8_t *emulator_flash_snapshot = NULL;
+static volatile sig_atomic_t emulator_flash_request = 0;
+
+unsigned int emulator_device_index = 0;
+unsigned int emulator_device_count = 1;
 
 uint32_t __stack_chk_guard;
 
 static int urandom = -1;
 
+static void setup_devices(void);
 static void setup_urandom(void);
+static void setup_seed(void);
 static void setup_flash(void);
 
 void setup(void) {
+	setup_devices();
 	setup_urandom();
+	setup_seed();
 	setup_flash();
 }
 
@@ -61,6 +86,78 @@ void emulatorRandom(void *buffer, size_t size) {
 	}
 }
 
+static pid_t device_pids[EMULATOR_MAX_DEVICES];
+
+static void devices_terminate(int sig) {
+	for (unsigned int i = 0; i < emulator_device_count; i++) {
+		if (device_pids[i] > 0) {
+			kill(device_pids[i], sig);
+		}
+	}
+	_exit(0);
+}
+
+/*
+ * With TREZOR_EMULATOR_DEVICES=N the process forks one worker per device and
+ * only the workers return from here. Firmware state is process-global, so each
+ * device gets its own address space, flash image and pair of UDP ports.
+ */
+static void setup_devices(void) {
+	const char *variable = getenv(ENV_EMULATOR_DEVICES);
+	if (!variable) {
+		return;
+	}
+
+	int count = atoi(variable);
+	if (count < 1 || count > EMULATOR_MAX_DEVICES) {
+		fprintf(stderr, "Invalid %s (1-%d)\n", ENV_EMULATOR_DEVICES, EMULATOR_MAX_DEVICES);
+		exit(1);
+	}
+	if (count == 1) {
+		return;
+	}
+	emulator_device_count = count;
+
+	for (unsigned int i = 0; i < emulator_device_count; i++) {
+		pid_t pid = fork();
+		if (pid < 0) {
+			perror("Failed to start emulated device");
+			devices_terminate(SIGTERM);
+		}
+		if (pid == 0) {
+#ifdef __linux__
+			prctl(PR_SET_PDEATHSIG, SIGTERM);
+#endif
+			emulator_device_index = i;
+			return;
+		}
+		device_pids[i] = pid;
+	}
+
+	signal(SIGINT, devices_terminate);
+	signal(SIGTERM, devices_terminate);
+
+	unsigned int running = emulator_device_count;
+	while (running > 0) {
+		int status;
+		pid_t pid = wait(&status);
+		if (pid < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			break;
+		}
+		for (unsigned int i = 0; i < emulator_device_count; i++) {
+			if (device_pids[i] == pid) {
+				fprintf(stderr, "Emulated device %u exited (%d)\n", i, status);
+				device_pids[i] = 0;
+				running--;
+			}
+		}
+	}
+	exit(0);
+}
+
 static void setup_urandom(void) {
 	urandom = open("/dev/urandom", O_RDONLY);
 	if (urandom < 0) {
@@ -69,8 +166,76 @@ static void setup_urandom(void) {
 	}
 }
 
+/*
+ * TREZOR_EMULATOR_SEED makes the random generator deterministic from the
+ * first random number on, e.g. for the storage uuid.
+ */
+static void setup_seed(void) {
+	const char *seed = getenv(ENV_EMULATOR_SEED);
+	if (!seed || !*seed) {
+		return;
+	}
+
+	if (emulator_device_count > 1) {
+		// every emulated device gets its own stream
+		char buffer[128];
+		int len = snprintf(buffer, sizeof(buffer), "%s/%u", seed, emulator_device_index);
+		if (len < 0 || (size_t) len >= sizeof(buffer)) {
+			fprintf(stderr, "%s is too long\n", ENV_EMULATOR_SEED);
+			exit(1);
+		}
+		emulatorRandomSeed((const uint8_t *) buffer, len);
+	} else {
+		emulatorRandomSeed((const uint8_t *) seed, strlen(seed));
+	}
+}
+
+static void flash_signal(int sig) {
+	emulator_flash_request = sig;
+}
+
+/*
+ * TREZOR_EMULATOR_FLASH=memory keeps the flash in anonymous memory only, the
+ * default file backend maps emulator.img and syncs it at svc_flash_lock().
+ */
+void emulatorSetFlashImage(const char *path) {
+	emulator_flash_image_set = true;
+	emulator_flash_image = path;
+}
+
 static void setup_flash(void) {
-	int fd = open(EMULATOR_FLASH_FILE, O_RDWR | O_SYNC | O_CREAT, 0644);
+	const char *backend = getenv(ENV_EMULATOR_FLASH);
+	if (emulator_flash_image_set) {
+		emulator_flash_file = (emulator_flash_image != NULL);
+	} else if (backend && strcmp(backend, "memory") == 0) {
+		emulator_flash_file = false;
+	} else if (backend && strcmp(backend, "file") != 0) {
+		fprintf(stderr, "Invalid %s (file or memory)\n", ENV_EMULATOR_FLASH);
+		exit(1);
+	}
+
+	signal(SIGUSR1, flash_signal);
+	signal(SIGUSR2, flash_signal);
+
+	if (!emulator_flash_file) {
+		emulator_flash_base = mmap(NULL, FLASH_TOTAL_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (emulator_flash_base == MAP_FAILED) {
+			perror("Failed to map flash emulation memory");
+			exit(1);
+		}
+		flash_erase_all_sectors(FLASH_CR_PROGRAM_X32);
+		return;
+	}
+
+	char filename[32];
+	if (emulator_device_count > 1) {
+		snprintf(filename, sizeof(filename), EMULATOR_FLASH_FILE_N, emulator_device_index);
+	} else {
+		strlcpy(filename, EMULATOR_FLASH_FILE, sizeof(filename));
+	}
+	const char *path = emulator_flash_image ? emulator_flash_image : filename;
+
+	int fd = open(path, O_RDWR | O_CREAT, 0644);
 	if (fd < 0) {
 		perror("Failed to open flash emulation file");
 		exit(1);
@@ -96,5 +261,56 @@ static void setup_flash(void) {
 
 		/* Initialize the flash */
 		flash_erase_all_sectors(FLASH_CR_PROGRAM_X32);
+		emulatorFlashSync();
+	}
+}
+
+void emulatorFlashSync(void) {
+	if (emulator_flash_file && msync(emulator_flash_base, FLASH_TOTAL_SIZE, MS_SYNC) != 0) {
+		perror("Failed to sync flash emulation file");
+	}
+}
+
+void emulatorFlashSnapshot(void) {
+	if (emulator_flash_snapshot == NULL) {
+		emulator_flash_snapshot = malloc(FLASH_TOTAL_SIZE);
+		if (emulator_flash_snapshot == NULL) {
+			perror("Failed to allocate flash snapshot");
+			return;
+		}
+	}
+	memcpy(emulator_flash_snapshot, emulator_flash_base, FLASH_TOTAL_SIZE);
+}
+
+bool emulatorFlashRestore(void) {
+	if (emulator_flash_snapshot == NULL) {
+		return false;
+	}
+	memcpy(emulator_flash_base, emulator_flash_snapshot, FLASH_TOTAL_SIZE);
+	emulatorFlashSync();
+	return true;
+}
+
+/*
+ * SIGUSR1 takes a snapshot of the flash and SIGUSR2 restores it. They are
+ * applied from trezor_loop() between messages, so neither a storage commit
+ * nor a handler using the session is torn in half. trezor_loop() reloads
+ * storage when this returns true.
+ */
+bool emulatorFlashPoll(void) {
+	int sig = emulator_flash_request;
+	if (sig == 0) {
+		return false;
+	}
+	emulator_flash_request = 0;
+
+	if (sig == SIGUSR1) {
+		emulatorFlashSnapshot();
+		return false;
+	}
+	if (!emulatorFlashRestore()) {
+		fprintf(stderr, "No flash snapshot to restore\n");
+		return false;
 	}
+	return true;
 }
@@ -0,0 +1,336 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Tests of libskyemu, run with make test-skyemu. Every test runs in its own
+ * process (the check default), as the firmware state is global.
+ */
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <check.h>
+
+#include "pb_decode.h"
+#include "pb_encode.h"
+#include "messages.h"
+#include "messages.pb.h"
+#include "skyemu.h"
+
+static uint8_t reply[MSG_OUT_SIZE];
+
+static bool send(char iface, uint16_t msg_id, const pb_field_t *fields, const void *msg)
+{
+	uint8_t data[256];
+	pb_ostream_t stream = pb_ostream_from_buffer(data, sizeof(data));
+	return pb_encode(&stream, fields, msg) && emu_send(iface, msg_id, data, stream.bytes_written);
+}
+
+// steps the firmware until it answers, returns the length of the reply or
+// a negative value
+static int wait_reply(char *reply_iface, uint16_t *reply_id)
+{
+	for (int i = 0; i < 100; i++) {
+		int ready = emu_step();
+		if (ready < 0) {
+			return -1;
+		}
+		if (ready > 0) {
+			return emu_recv(reply_iface, reply_id, reply, sizeof(reply));
+		}
+	}
+	return -1;
+}
+
+// sends msg on iface and steps the firmware until it answers, returns the
+// length of the reply or a negative value
+static int call(char iface, uint16_t msg_id, const pb_field_t *fields, const void *msg, char *reply_iface, uint16_t *reply_id)
+{
+	if (!send(iface, msg_id, fields, msg)) {
+		return -1;
+	}
+	return wait_reply(reply_iface, reply_id);
+}
+
+START_TEST(test_initialize_features)
+{
+	emu_init(NULL);
+
+	Initialize msg;
+	memset(&msg, 0, sizeof(msg));
+	char iface;
+	uint16_t msg_id;
+	int len = call(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, Initialize_fields, &msg, &iface, &msg_id);
+	ck_assert(len >= 0);
+	ck_assert_int_eq(iface, EMU_IFACE_MAIN);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_Features);
+
+	Features features;
+	memset(&features, 0, sizeof(features));
+	pb_istream_t stream = pb_istream_from_buffer(reply, len);
+	ck_assert(pb_decode(&stream, Features_fields, &features));
+	ck_assert(features.has_vendor);
+	ck_assert_str_eq(features.vendor, "Skycoin Foundation");
+	ck_assert(features.has_initialized);
+	ck_assert(!features.initialized);
+
+	// nothing else was queued
+	ck_assert_int_eq(emu_recv(&iface, &msg_id, reply, sizeof(reply)), -1);
+}
+END_TEST
+
+START_TEST(test_debug_link)
+{
+	emu_init(NULL);
+
+	ck_assert(!emu_send('x', MessageType_MessageType_Initialize, reply, 0));
+#if DEBUG_LINK
+	DebugLinkGetState msg;
+	memset(&msg, 0, sizeof(msg));
+	char iface;
+	uint16_t msg_id;
+	int len = call(EMU_IFACE_DEBUG, MessageType_MessageType_DebugLinkGetState, DebugLinkGetState_fields, &msg, &iface, &msg_id);
+	ck_assert(len >= 0);
+	ck_assert_int_eq(iface, EMU_IFACE_DEBUG);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_DebugLinkState);
+#else
+	ck_assert(!emu_send(EMU_IFACE_DEBUG, MessageType_MessageType_DebugLinkGetState, reply, 0));
+#endif
+}
+END_TEST
+
+START_TEST(test_reply_too_large)
+{
+	emu_init(NULL);
+
+	Initialize msg;
+	memset(&msg, 0, sizeof(msg));
+	char iface;
+	uint16_t msg_id;
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, Initialize_fields, &msg, &iface, &msg_id) >= 0);
+	// a reply that does not fit stays queued
+	ck_assert(emu_send(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, reply, 0));
+	ck_assert_int_eq(emu_step(), 1);
+	ck_assert_int_eq(emu_recv(&iface, &msg_id, reply, 1), -2);
+	ck_assert(emu_recv(&iface, &msg_id, reply, sizeof(reply)) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_Features);
+}
+END_TEST
+
+START_TEST(test_reply_overflow)
+{
+	emu_init(NULL);
+
+	// more replies than the output queue holds
+	for (int i = 0; i < 1000; i++) {
+		ck_assert(emu_send(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, reply, 0));
+	}
+	int ready = 0;
+	for (int i = 0; i < 2000 && ready >= 0; i++) {
+		ready = emu_step();
+	}
+	ck_assert_int_eq(ready, -1);
+
+	// what was kept can still be read
+	char iface;
+	uint16_t msg_id;
+	ck_assert(emu_recv(&iface, &msg_id, reply, sizeof(reply)) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_Features);
+}
+END_TEST
+
+static void *init_and_call(void *arg)
+{
+	(void)arg;
+	emu_init(NULL);
+
+	Initialize msg;
+	memset(&msg, 0, sizeof(msg));
+	char iface;
+	uint16_t msg_id;
+	static int len;
+	len = call(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, Initialize_fields, &msg, &iface, &msg_id);
+	return &len;
+}
+
+START_TEST(test_small_host_stack)
+{
+	// emu_init runs on the host stack, which it must leave alone
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, 64 * 1024);
+	pthread_t thread;
+	ck_assert_int_eq(pthread_create(&thread, &attr, init_and_call, NULL), 0);
+	void *len;
+	ck_assert_int_eq(pthread_join(thread, &len), 0);
+	ck_assert(*(int *)len >= 0);
+}
+END_TEST
+
+#if DEBUG_LINK
+// loads a mnemonic with passphrase protection, confirmed on the debug link
+static void load_device(void)
+{
+	char iface;
+	uint16_t msg_id;
+	LoadDevice load;
+	memset(&load, 0, sizeof(load));
+	load.has_mnemonic = true;
+	strcpy(load.mnemonic, "all all all all all all all all all all all all");
+	load.has_passphrase_protection = true;
+	load.passphrase_protection = true;
+	load.has_skip_checksum = true;
+	load.skip_checksum = true;
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_LoadDevice, LoadDevice_fields, &load, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_ButtonRequest);
+	ButtonAck ack;
+	memset(&ack, 0, sizeof(ack));
+	ck_assert(send(EMU_IFACE_MAIN, MessageType_MessageType_ButtonAck, ButtonAck_fields, &ack));
+	DebugLinkDecision decision;
+	memset(&decision, 0, sizeof(decision));
+	decision.yes_no = true;
+	ck_assert(call(EMU_IFACE_DEBUG, MessageType_MessageType_DebugLinkDecision, DebugLinkDecision_fields, &decision, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_Success);
+}
+
+// derives address_n addresses of the wallet of passphrase into addresses
+static void get_addresses(const char *passphrase, uint32_t address_n, ResponseSkycoinAddress *addresses)
+{
+	char iface;
+	uint16_t msg_id;
+	Initialize init;
+	memset(&init, 0, sizeof(init));
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, Initialize_fields, &init, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_Features);
+
+	SkycoinAddress address;
+	memset(&address, 0, sizeof(address));
+	address.address_n = address_n;
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_SkycoinAddress, SkycoinAddress_fields, &address, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_PassphraseRequest);
+	PassphraseAck ack;
+	memset(&ack, 0, sizeof(ack));
+	ack.has_passphrase = true;
+	strcpy(ack.passphrase, passphrase);
+	int len = call(EMU_IFACE_MAIN, MessageType_MessageType_PassphraseAck, PassphraseAck_fields, &ack, &iface, &msg_id);
+	ck_assert(len >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_ResponseSkycoinAddress);
+
+	memset(addresses, 0, sizeof(*addresses));
+	pb_istream_t stream = pb_istream_from_buffer(reply, len);
+	ck_assert(pb_decode(&stream, ResponseSkycoinAddress_fields, addresses));
+	ck_assert_int_eq(addresses->addresses_count, address_n);
+}
+
+START_TEST(test_passphrase_cancel)
+{
+	emu_init(NULL);
+	load_device();
+
+	char iface;
+	uint16_t msg_id;
+
+	// a cancelled prompt derives the wallet without passphrase
+	SkycoinAddress address;
+	memset(&address, 0, sizeof(address));
+	address.address_n = 1;
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_SkycoinAddress, SkycoinAddress_fields, &address, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_PassphraseRequest);
+	Cancel cancel;
+	memset(&cancel, 0, sizeof(cancel));
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_Cancel, Cancel_fields, &cancel, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_ResponseSkycoinAddress);
+
+	// which is not kept to resume the next walk from
+	address.has_start_index = true;
+	address.start_index = 1;
+	ck_assert(call(EMU_IFACE_MAIN, MessageType_MessageType_SkycoinAddress, SkycoinAddress_fields, &address, &iface, &msg_id) >= 0);
+	ck_assert_int_eq(msg_id, MessageType_MessageType_PassphraseRequest);
+}
+END_TEST
+
+START_TEST(test_address_cache_recycle)
+{
+	emu_init(NULL);
+	load_device();
+
+	// the address cache holds two wallets of 99 addresses, the third one
+	// recycles it
+	static const char *passphrases[] = {"first", "second", "third"};
+	static ResponseSkycoinAddress first[3], again;
+	for (int i = 0; i < 3; i++) {
+		get_addresses(passphrases[i], 99, &first[i]);
+		ck_assert(i == 0 || strcmp(first[i].addresses[0], first[i - 1].addresses[0]) != 0);
+	}
+	for (int i = 2; i >= 0; i--) {
+		get_addresses(passphrases[i], 99, &again);
+		for (int j = 0; j < 99; j++) {
+			ck_assert_str_eq(again.addresses[j], first[i].addresses[j]);
+		}
+	}
+
+	// the storage itself is untouched
+	char iface;
+	uint16_t msg_id;
+	Initialize init;
+	memset(&init, 0, sizeof(init));
+	int len = call(EMU_IFACE_MAIN, MessageType_MessageType_Initialize, Initialize_fields, &init, &iface, &msg_id);
+	ck_assert(len >= 0);
+	Features features;
+	memset(&features, 0, sizeof(features));
+	pb_istream_t stream = pb_istream_from_buffer(reply, len);
+	ck_assert(pb_decode(&stream, Features_fields, &features));
+	ck_assert(features.initialized);
+	ck_assert(features.passphrase_protection);
+}
+END_TEST
+#endif
+
+Suite *test_suite(void)
+{
+	Suite *s = suite_create("skyemu");
+	TCase *tc;
+
+	tc = tcase_create("messages");
+	tcase_add_test(tc, test_initialize_features);
+	tcase_add_test(tc, test_debug_link);
+	tcase_add_test(tc, test_reply_too_large);
+	tcase_add_test(tc, test_reply_overflow);
+	tcase_add_test(tc, test_small_host_stack);
+#if DEBUG_LINK
+	tcase_add_test(tc, test_passphrase_cancel);
+	tcase_add_test(tc, test_address_cache_recycle);
+#endif
+	suite_add_tcase(s, tc);
+
+	return s;
+}
+
+int main(void)
+{
+	int number_failed;
+	Suite *s = test_suite();
+	SRunner *sr = srunner_create(s);
+	srunner_run_all(sr, CK_VERBOSE);
+	number_failed = srunner_ntests_failed(sr);
+	srunner_free(sr);
+	if (number_failed == 0) {
+		printf("PASSED ALL TESTS\n");
+	}
+	return number_failed;
+}
@@ -17,16 +17,65 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "timer.h"
 
-void timer_init(void) {}
+#define ENV_EMULATOR_CLOCK "TREZOR_EMULATOR_CLOCK"
 
-uint32_t timer_ms(void) {
+/*
+ * The virtual clock only moves when the firmware sleeps (usbSleep) or when it
+ * is advanced explicitly, so delays cost no wall-clock time and tests see the
+ * same timestamps on every run. clock_offset keeps timer_ms() monotonic when
+ * switching back and forth.
+ */
+static bool clock_virtual = false;
+static uint32_t clock_virtual_ms = 0;
+static uint32_t clock_offset = 0;
+
+static uint32_t clock_real_ms(void) {
 	struct timespec t;
 	clock_gettime(CLOCK_MONOTONIC, &t);
 
         uint32_t msec = t.tv_sec * 1000 + (t.tv_nsec / 1000000);
 	return msec;
 }
+
+void timer_init(void) {
+	const char *variable = getenv(ENV_EMULATOR_CLOCK);
+	if (variable && strcmp(variable, "virtual") == 0) {
+		emulatorClockSetVirtual(true);
+	}
+}
+
+uint32_t timer_ms(void) {
+	if (clock_virtual) {
+		return clock_virtual_ms;
+	}
+	return clock_real_ms() + clock_offset;
+}
+
+void emulatorClockSetVirtual(bool enable) {
+	if (enable == clock_virtual) {
+		return;
+	}
+	if (enable) {
+		clock_virtual_ms = clock_real_ms() + clock_offset;
+	} else {
+		clock_offset = clock_virtual_ms - clock_real_ms();
+	}
+	clock_virtual = enable;
+}
+
+bool emulatorClockIsVirtual(void) {
+	return clock_virtual;
+}
+
+void emulatorClockAdvance(uint32_t ms) {
+	if (clock_virtual) {
+		clock_virtual_ms += ms;
+	}
+}
@@ -0,0 +1,134 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * Copyright (C) 2017 Saleem Rashid <trezor@saleemrashid.com>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "trace.h"
+
+#define ENV_EMULATOR_RECORD "TREZOR_EMULATOR_RECORD"
+
+static const char trace_magic[8] = { 'S', 'K', 'Y', 'T', 'R', 'A', 'C', 'E' };
+
+static FILE *record_file = NULL;
+static uint64_t record_last = 0;
+
+uint64_t trace_now(void) {
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t) t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+
+FILE *trace_open(const char *path, bool write) {
+	// each emulated device has its own trace
+	char name[PATH_MAX];
+	int len;
+	if (emulator_device_count > 1) {
+		len = snprintf(name, sizeof(name), "%s.%u", path, emulator_device_index);
+	} else {
+		len = snprintf(name, sizeof(name), "%s", path);
+	}
+	if (len < 0 || (size_t) len >= sizeof(name)) {
+		fprintf(stderr, "Trace path is too long\n");
+		exit(1);
+	}
+
+	FILE *file = fopen(name, write ? "wb" : "rb");
+	if (!file) {
+		perror("Failed to open trace");
+		exit(1);
+	}
+
+	uint8_t header[sizeof(trace_magic) + 1];
+	if (write) {
+		memcpy(header, trace_magic, sizeof(trace_magic));
+		header[sizeof(trace_magic)] = TRACE_VERSION;
+		fwrite(header, sizeof(header), 1, file);
+	} else if (fread(header, sizeof(header), 1, file) != 1 || memcmp(header, trace_magic, sizeof(trace_magic)) != 0 || header[sizeof(trace_magic)] != TRACE_VERSION) {
+		fprintf(stderr, "%s is not a version %d trace\n", name, TRACE_VERSION);
+		exit(1);
+	}
+
+	return file;
+}
+
+enum trace_status trace_read(FILE *file, struct trace_record *record) {
+	uint8_t header[7];
+	size_t got = fread(header, 1, sizeof(header), file);
+	if (got == 0 && feof(file)) {
+		return TRACE_END;
+	}
+	if (got != sizeof(header)) {
+		fprintf(stderr, "Truncated trace\n");
+		return TRACE_TRUNCATED;
+	}
+
+	record->delta = header[0] + (header[1] << 8) + (header[2] << 16) + ((uint32_t) header[3] << 24);
+	record->flags = header[4];
+	record->len = header[5] + (header[6] << 8);
+	if (record->len > sizeof(record->data) || fread(record->data, record->len, 1, file) != 1) {
+		fprintf(stderr, "Truncated trace\n");
+		return TRACE_TRUNCATED;
+	}
+
+	return TRACE_RECORD;
+}
+
+void emulatorTraceInit(void) {
+	const char *path = getenv(ENV_EMULATOR_RECORD);
+	if (!path) {
+		return;
+	}
+
+	record_file = trace_open(path, true);
+	record_last = trace_now();
+	atexit(emulatorTraceFlush);
+}
+
+void emulatorTraceRecord(bool out, int iface, const void *buffer, size_t size) {
+	if (!record_file) {
+		return;
+	}
+
+	uint64_t now = trace_now();
+	uint64_t delta = now - record_last;
+	record_last = now;
+	if (delta > UINT32_MAX) {
+		delta = UINT32_MAX;
+	}
+
+	uint8_t header[7];
+	header[0] = delta;
+	header[1] = delta >> 8;
+	header[2] = delta >> 16;
+	header[3] = delta >> 24;
+	header[4] = (iface & TRACE_IFACE_MASK) | (out ? TRACE_OUT : 0);
+	header[5] = size;
+	header[6] = size >> 8;
+	fwrite(header, sizeof(header), 1, record_file);
+	fwrite(buffer, size, 1, record_file);
+}
+
+void emulatorTraceFlush(void) {
+	if (record_file) {
+		fflush(record_file);
+	}
+}
@@ -0,0 +1,60 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * Copyright (C) 2017 Saleem Rashid <trezor@saleemrashid.com>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * Wire trace: "SKYTRACE" and a version byte, then one record per report
+ * the firmware read or wrote: microseconds since the previous record (4,
+ * little endian), flags (1), length (2, little endian) and the report.
+ */
+#define TRACE_VERSION 1
+
+// flags: interface in the low bits, TRACE_OUT for reports from the firmware
+#define TRACE_IFACE_MASK 0x03
+#define TRACE_OUT        0x80
+
+struct trace_record {
+	uint32_t delta;
+	uint8_t flags;
+	uint16_t len;
+	uint8_t data[EMULATOR_FRAME_MAX];
+};
+
+uint64_t trace_now(void);
+FILE *trace_open(const char *path, bool write);
+// results of trace_read
+enum trace_status {
+	TRACE_END,
+	TRACE_RECORD,
+	TRACE_TRUNCATED,
+};
+
+enum trace_status trace_read(FILE *file, struct trace_record *record);
+
+void emulatorTraceInit(void);
+void emulatorTraceRecord(bool out, int iface, const void *buffer, size_t size);
+void emulatorTraceFlush(void);
+
+#endif
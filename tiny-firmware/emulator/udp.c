@@ -19,13 +19,92 @@
 
 #include <arpa/inet.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <netinet/tcp.h>
 #include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
 
 #define TREZOR_UDP_PORT 21324
 
+#define ENV_EMULATOR_STREAM "TREZOR_EMULATOR_STREAM"
+#define ENV_EMULATOR_REPLAY "TREZOR_EMULATOR_REPLAY"
+#define ENV_EMULATOR_REPLAY_PACING "TREZOR_EMULATOR_REPLAY_PACING"
+
+// SDL only updates the keyboard state while its event queue is pumped
+#define EMULATOR_EVENT_INTERVAL 20
+
+// reports queued in each direction between the I/O thread and the firmware
+#define EMULATOR_RING_SIZE 256
+
+// how long a replay waits for a recorded reply before calling it missing
+#define EMULATOR_REPLAY_TIMEOUT 10000
+
+/*
+ * Sockets are owned by an I/O thread, which answers transport pings itself
+ * and hands reports to the firmware through single-producer single-consumer
+ * rings, so a handler busy with crypto does not stall the transport.
+ */
+struct usb_report {
+	uint8_t iface;
+	uint8_t len;
+	uint8_t data[64];
+};
+
+struct usb_ring {
+	_Atomic uint32_t head;	// only written by the producer
+	_Atomic uint32_t tail;	// only written by the consumer
+	struct usb_report reports[EMULATOR_RING_SIZE];
+};
+
+static struct usb_ring rx_ring;	// I/O thread -> firmware
+static struct usb_ring tx_ring;	// firmware -> I/O thread
+
+static int rx_wake[2];
+static int tx_wake[2];
+
+/*
+ * Optional stream transport (TREZOR_EMULATOR_STREAM=tcp:<port> or
+ * unix:<path>) carrying whole messages as "##" + id (2) + length (4) +
+ * payload, i.e. the report framing without the per-report '?'. A complete
+ * message is handed to the firmware as a single frame, replies are
+ * reassembled from the 64 byte reports the firmware produces. The socket
+ * is non-blocking, what the host does not take yet waits in tx and is sent
+ * when poll() reports POLLOUT.
+ */
+struct usb_stream {
+	int listen_fd;
+	int fd;
+	uint8_t rx[EMULATOR_FRAME_MAX - 1];
+	size_t rx_len;
+	uint8_t tx[EMULATOR_FRAME_MAX - 1];
+	size_t tx_len;
+	uint32_t tx_remaining;
+};
+
+static struct usb_stream usb_stream = { .listen_fd = -1, .fd = -1 };
+
+// '?' + one stream message, owned by the firmware while the length is set
+static uint8_t stream_frame[EMULATOR_FRAME_MAX];
+static _Atomic uint32_t stream_frame_len;
+
 struct usb_socket {
 	int fd;
 	struct sockaddr_in from;
@@ -67,7 +146,7 @@ static size_t socket_write(struct usb_socket *sock, const void *buffer, size_t s
 	return size;
 }
 
-static size_t socket_read(struct usb_socket *sock, void *buffer, size_t size) {
+static ssize_t socket_read(struct usb_socket *sock, void *buffer, size_t size) {
 	sock->fromlen = sizeof(sock->from);
 	ssize_t n = recvfrom(sock->fd, buffer, size, MSG_DONTWAIT, (struct sockaddr *) &sock->from, &sock->fromlen);
 
@@ -75,7 +154,7 @@ static size_t socket_read(struct usb_socket *sock, void *buffer, size_t size) {
 		if (errno != EAGAIN && errno != EWOULDBLOCK) {
 			perror("Failed to read socket");
 		}
-		return 0;
+		return -1;
 	}
 
 	static const char msg_ping[] = { 'P', 'I', 'N', 'G', 'P', 'I', 'N', 'G' };
@@ -89,35 +168,610 @@ static size_t socket_read(struct usb_socket *sock, void *buffer, size_t size) {
 	return n;
 }
 
+static bool ring_push(struct usb_ring *ring, const struct usb_report *report) {
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	if (head - tail == EMULATOR_RING_SIZE) {
+		return false;
+	}
+	ring->reports[head % EMULATOR_RING_SIZE] = *report;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+	return true;
+}
+
+static bool ring_pop(struct usb_ring *ring, struct usb_report *report) {
+	uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+	if (head == tail) {
+		return false;
+	}
+	*report = ring->reports[tail % EMULATOR_RING_SIZE];
+	atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+	return true;
+}
+
+static uint32_t ring_count(struct usb_ring *ring) {
+	return atomic_load_explicit(&ring->head, memory_order_acquire) - atomic_load_explicit(&ring->tail, memory_order_acquire);
+}
+
+static void wake_setup(int fds[2]) {
+	if (pipe(fds) != 0) {
+		perror("Failed to create wake pipe");
+		exit(1);
+	}
+	fcntl(fds[0], F_SETFL, O_NONBLOCK);
+	fcntl(fds[1], F_SETFL, O_NONBLOCK);
+}
+
+static void wake(int fd) {
+	// a full pipe already wakes the reader
+	const uint8_t c = 0;
+	if (write(fd, &c, 1) < 0 && errno != EAGAIN) {
+		perror("Failed to wake thread");
+	}
+}
+
+static void wake_drain(int fd) {
+	uint8_t buffer[64];
+	while (read(fd, buffer, sizeof(buffer)) > 0) {
+	}
+}
+
+static bool socket_receive(struct usb_socket *sock, uint8_t iface) {
+	bool received = false;
+	struct usb_report report;
+
+	while (ring_count(&rx_ring) < EMULATOR_RING_SIZE) {
+		ssize_t n = socket_read(sock, report.data, sizeof(report.data));
+		if (n < 0) {
+			break;
+		}
+		if (n > 0) {
+			report.iface = iface;
+			report.len = n;
+			ring_push(&rx_ring, &report);
+			received = true;
+		}
+	}
+
+	return received;
+}
+
+static void stream_setup(void) {
+	const char *variable = getenv(ENV_EMULATOR_STREAM);
+	if (!variable) {
+		return;
+	}
+
+	int fd;
+	if (strncmp(variable, "tcp:", 4) == 0) {
+		fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0) {
+			perror("Failed to create stream socket");
+			exit(1);
+		}
+		int one = 1;
+		setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+		struct sockaddr_in addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(atoi(variable + 4) + emulator_device_index);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+			perror("Failed to bind stream socket");
+			exit(1);
+		}
+	} else if (strncmp(variable, "unix:", 5) == 0) {
+		fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (fd < 0) {
+			perror("Failed to create stream socket");
+			exit(1);
+		}
+
+		struct sockaddr_un addr;
+		memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		int len;
+		if (emulator_device_count > 1) {
+			len = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s.%u", variable + 5, emulator_device_index);
+		} else {
+			len = snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", variable + 5);
+		}
+		if (len < 0 || (size_t) len >= sizeof(addr.sun_path)) {
+			fprintf(stderr, "%s path is too long\n", ENV_EMULATOR_STREAM);
+			exit(1);
+		}
+		unlink(addr.sun_path);
+		if (bind(fd, (struct sockaddr *) &addr, sizeof(addr)) != 0) {
+			perror("Failed to bind stream socket");
+			exit(1);
+		}
+	} else {
+		fprintf(stderr, "Invalid %s (tcp:<port> or unix:<path>)\n", ENV_EMULATOR_STREAM);
+		exit(1);
+	}
+
+	if (listen(fd, 1) != 0) {
+		perror("Failed to listen on stream socket");
+		exit(1);
+	}
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	usb_stream.listen_fd = fd;
+}
+
+static void stream_close(void) {
+	close(usb_stream.fd);
+	usb_stream.fd = -1;
+	usb_stream.rx_len = 0;
+	usb_stream.tx_len = 0;
+	usb_stream.tx_remaining = 0;
+}
+
+static void stream_accept(void) {
+	int fd = accept(usb_stream.listen_fd, NULL, NULL);
+	if (fd < 0) {
+		return;
+	}
+
+	// a new host takes over from the previous one
+	if (usb_stream.fd >= 0) {
+		stream_close();
+	}
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	usb_stream.fd = fd;
+}
+
+static bool stream_deliver(void) {
+	if (usb_stream.fd < 0 || usb_stream.rx_len < 8 || atomic_load_explicit(&stream_frame_len, memory_order_acquire) != 0) {
+		return false;
+	}
+
+	const uint8_t *rx = usb_stream.rx;
+	if (rx[0] != '#' || rx[1] != '#') {
+		fprintf(stderr, "Invalid stream framing\n");
+		stream_close();
+		return false;
+	}
+	uint32_t size = ((uint32_t) rx[4] << 24) + (rx[5] << 16) + (rx[6] << 8) + rx[7];
+	if (size > sizeof(usb_stream.rx) - 8) {
+		fprintf(stderr, "Stream message too big\n");
+		stream_close();
+		return false;
+	}
+	size += 8;
+	if (usb_stream.rx_len < size) {
+		return false;
+	}
+
+	stream_frame[0] = '?';
+	memcpy(stream_frame + 1, rx, size);
+	memmove(usb_stream.rx, rx + size, usb_stream.rx_len - size);
+	usb_stream.rx_len -= size;
+	atomic_store_explicit(&stream_frame_len, size + 1, memory_order_release);
+	return true;
+}
+
+static void stream_receive(void) {
+	ssize_t n = recv(usb_stream.fd, usb_stream.rx + usb_stream.rx_len, sizeof(usb_stream.rx) - usb_stream.rx_len, MSG_DONTWAIT);
+	if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+		stream_close();
+		return;
+	}
+	if (n > 0) {
+		usb_stream.rx_len += n;
+	}
+}
+
+static void stream_write(const struct usb_report *report) {
+	if (usb_stream.fd < 0 || report->len < 1) {
+		return;
+	}
+
+	const uint8_t *data = report->data + 1;
+	uint32_t len = report->len - 1;
+	if (usb_stream.tx_remaining == 0) {
+		if (len < 8) {
+			return;
+		}
+		usb_stream.tx_remaining = 8 + (((uint32_t) data[4] << 24) + (data[5] << 16) + (data[6] << 8) + data[7]);
+	}
+	if (len > usb_stream.tx_remaining) {
+		len = usb_stream.tx_remaining;
+	}
+	usb_stream.tx_remaining -= len;
+
+	memcpy(usb_stream.tx + usb_stream.tx_len, data, len);
+	usb_stream.tx_len += len;
+}
+
+static void stream_flush(void) {
+	while (usb_stream.fd >= 0 && usb_stream.tx_len > 0) {
+		ssize_t n = send(usb_stream.fd, usb_stream.tx, usb_stream.tx_len, MSG_NOSIGNAL);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno != EAGAIN && errno != EWOULDBLOCK) {
+				stream_close();
+			}
+			return;
+		}
+		memmove(usb_stream.tx, usb_stream.tx + n, usb_stream.tx_len - n);
+		usb_stream.tx_len -= n;
+	}
+}
+
+static void *socket_thread(void *arg) {
+	(void) arg;
+
+	// signals are for the firmware thread
+	sigset_t set;
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	struct pollfd fds[5] = {
+		{ .fd = usb_main.fd },
+		{ .fd = usb_debug.fd },
+		{ .fd = tx_wake[0], .events = POLLIN },
+		{ .fd = usb_stream.listen_fd, .events = POLLIN },
+		{ .fd = -1 },
+	};
+
+	for (;;) {
+		// stop reading while the firmware is behind, the kernel keeps queueing
+		bool full = ring_count(&rx_ring) == EMULATOR_RING_SIZE;
+		fds[0].events = full ? 0 : POLLIN;
+		fds[1].events = full ? 0 : POLLIN;
+		fds[4].fd = usb_stream.fd;
+		fds[4].events = (usb_stream.rx_len < sizeof(usb_stream.rx)) ? POLLIN : 0;
+		if (usb_stream.tx_len > 0) {
+			fds[4].events |= POLLOUT;
+		}
+
+		if (poll(fds, 5, full ? 1 : -1) < 0 && errno != EINTR) {
+			perror("Failed to poll socket");
+		}
+
+		wake_drain(tx_wake[0]);
+		struct usb_report report;
+		// a host not reading the stream holds up the replies behind it
+		while (usb_stream.tx_len + sizeof(report.data) <= sizeof(usb_stream.tx) && ring_pop(&tx_ring, &report)) {
+			if (report.iface == 2) {
+				stream_write(&report);
+			} else {
+				socket_write(report.iface == 0 ? &usb_main : &usb_debug, report.data, report.len);
+			}
+		}
+		stream_flush();
+
+		bool received = socket_receive(&usb_main, 0);
+		received |= socket_receive(&usb_debug, 1);
+
+		if (fds[3].revents & POLLIN) {
+			stream_accept();
+		}
+		if (usb_stream.fd >= 0 && usb_stream.fd == fds[4].fd && (fds[4].revents & (POLLIN | POLLHUP | POLLERR))) {
+			stream_receive();
+		}
+		received |= stream_deliver();
+
+		if (received) {
+			wake(rx_wake[1]);
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Replay (TREZOR_EMULATOR_REPLAY=<trace>) takes the place of the sockets:
+ * recorded input is fed to the firmware, at full speed or with the recorded
+ * gaps (TREZOR_EMULATOR_REPLAY_PACING=original), and every report the
+ * firmware writes is compared with the recorded one. An exchange is the
+ * input up to a reply, its latency runs from the last input report to the
+ * last reply report. Responses only match when the replay starts from the
+ * same flash and random seed as the recording.
+ */
+struct replay_state {
+	FILE *trace;
+	bool paced;
+	uint64_t last;			// when the previous record was handled
+	uint64_t sent;			// when the last input report was delivered
+	uint64_t replied;		// when the last reply report arrived
+	uint64_t recorded_elapsed;	// recorded time since the last input report
+	uint64_t recorded_latency;
+	bool replying;
+	bool stalled;
+	uint16_t msg_id;
+	uint32_t records;
+	uint32_t exchanges;
+	uint32_t divergences;
+	uint64_t total_recorded;
+	uint64_t total_replayed;
+};
+
+static void replay_exchange(struct replay_state *replay) {
+	if (!replay->replying) {
+		return;
+	}
+
+	uint64_t latency = replay->replied - replay->sent;
+	printf("replay: #%u id %u recorded %llu us replayed %llu us\n", replay->exchanges, replay->msg_id, (unsigned long long) replay->recorded_latency, (unsigned long long) latency);
+	replay->exchanges++;
+	replay->total_recorded += replay->recorded_latency;
+	replay->total_replayed += latency;
+	replay->replying = false;
+}
+
+static void replay_unexpected(struct replay_state *replay) {
+	struct usb_report report;
+	while (ring_pop(&tx_ring, &report)) {
+		printf("replay: record %u: unexpected report on iface %u\n", replay->records, report.iface);
+		replay->divergences++;
+	}
+}
+
+static void replay_deliver(struct replay_state *replay, const struct trace_record *record) {
+	replay_exchange(replay);
+	replay_unexpected(replay);
+
+	if (replay->paced) {
+		uint64_t due = replay->last + record->delta;
+		uint64_t now = trace_now();
+		if (due > now) {
+			struct timespec t = { .tv_sec = (due - now) / 1000000, .tv_nsec = ((due - now) % 1000000) * 1000 };
+			nanosleep(&t, NULL);
+		}
+	}
+
+	const uint8_t *data = record->data;
+	if (record->len >= 5 && data[0] == '?' && data[1] == '#' && data[2] == '#') {
+		replay->msg_id = (data[3] << 8) + data[4];
+	}
+
+	uint8_t iface = record->flags & TRACE_IFACE_MASK;
+	if (iface == 2) {
+		while (atomic_load_explicit(&stream_frame_len, memory_order_acquire) != 0) {
+			poll(NULL, 0, 1);
+		}
+		memcpy(stream_frame, data, record->len);
+		atomic_store_explicit(&stream_frame_len, record->len, memory_order_release);
+	} else {
+		struct usb_report report;
+		report.iface = iface;
+		report.len = record->len < sizeof(report.data) ? record->len : sizeof(report.data);
+		memcpy(report.data, data, report.len);
+		while (!ring_push(&rx_ring, &report)) {
+			poll(NULL, 0, 1);
+		}
+	}
+	wake(rx_wake[1]);
+
+	replay->sent = trace_now();
+	replay->recorded_elapsed = 0;
+	replay->stalled = false;
+}
+
+static void replay_expect(struct replay_state *replay, const struct trace_record *record) {
+	replay->recorded_elapsed += record->delta;
+
+	// once a reply went missing the rest of it will not arrive either
+	struct usb_report report;
+	bool received = false;
+	if (!replay->stalled) {
+		uint64_t deadline = trace_now() + EMULATOR_REPLAY_TIMEOUT * 1000ULL;
+		struct pollfd fds[1] = {
+			{ .fd = tx_wake[0], .events = POLLIN },
+		};
+		for (;;) {
+			wake_drain(tx_wake[0]);
+			if (ring_pop(&tx_ring, &report)) {
+				received = true;
+				break;
+			}
+			uint64_t now = trace_now();
+			if (now >= deadline) {
+				break;
+			}
+			poll(fds, 1, (deadline - now + 999) / 1000);
+		}
+	}
+
+	if (!received) {
+		printf("replay: record %u: missing reply on iface %u\n", replay->records, record->flags & TRACE_IFACE_MASK);
+		replay->divergences++;
+		replay->stalled = true;
+		return;
+	}
+
+	if (report.iface != (record->flags & TRACE_IFACE_MASK) || report.len != record->len || memcmp(report.data, record->data, report.len) != 0) {
+		printf("replay: record %u: reply differs from the recording\n", replay->records);
+		replay->divergences++;
+	}
+
+	replay->replied = trace_now();
+	replay->recorded_latency = replay->recorded_elapsed;
+	replay->replying = true;
+}
+
+// exit status of a finished replay, -1 while it runs
+static _Atomic int replay_exit_status = -1;
+
+/*
+ * Exits once the replay is over. Called by the firmware thread where it
+ * waits for the host, so never in the middle of a flash write.
+ */
+static void replay_exit_poll(void) {
+	int status = atomic_load_explicit(&replay_exit_status, memory_order_acquire);
+	if (status >= 0) {
+		emulatorFlashSync();
+		exit(status);
+	}
+}
+
+static void *replay_thread(void *arg) {
+	struct replay_state *replay = arg;
+
+	sigset_t set;
+	sigfillset(&set);
+	pthread_sigmask(SIG_BLOCK, &set, NULL);
+
+	static struct trace_record record;
+	enum trace_status status;
+	replay->last = trace_now();
+	while ((status = trace_read(replay->trace, &record)) == TRACE_RECORD) {
+		if (record.flags & TRACE_OUT) {
+			replay_expect(replay, &record);
+		} else {
+			replay_deliver(replay, &record);
+		}
+		replay->last = trace_now();
+		replay->records++;
+	}
+	replay_exchange(replay);
+
+	// give late extra replies a moment to show up
+	poll(NULL, 0, 100);
+	replay_unexpected(replay);
+
+	printf("replay: %u records, %u exchanges, recorded %llu us, replayed %llu us, %u divergences%s\n", replay->records, replay->exchanges, (unsigned long long) replay->total_recorded, (unsigned long long) replay->total_replayed, replay->divergences, status == TRACE_TRUNCATED ? ", truncated trace" : "");
+	// a damaged trace did not replay everything that was recorded
+	atomic_store_explicit(&replay_exit_status, (replay->divergences || status == TRACE_TRUNCATED) ? 1 : 0, memory_order_release);
+	wake(rx_wake[1]);
+	return NULL;
+}
+
+static bool replay_setup(void) {
+	const char *path = getenv(ENV_EMULATOR_REPLAY);
+	if (!path) {
+		return false;
+	}
+
+	static struct replay_state replay;
+	replay.trace = trace_open(path, false);
+
+	const char *pacing = getenv(ENV_EMULATOR_REPLAY_PACING);
+	if (pacing && strcmp(pacing, "original") == 0) {
+		replay.paced = true;
+	} else if (pacing && strcmp(pacing, "fast") != 0) {
+		fprintf(stderr, "Invalid %s (fast or original)\n", ENV_EMULATOR_REPLAY_PACING);
+		exit(1);
+	}
+
+	wake_setup(rx_wake);
+	wake_setup(tx_wake);
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, replay_thread, &replay) != 0) {
+		perror("Failed to start replay thread");
+		exit(1);
+	}
+	pthread_detach(thread);
+	return true;
+}
+
 void emulatorSocketInit(void) {
-	usb_main.fd = socket_setup(TREZOR_UDP_PORT);
+	emulatorTraceInit();
+	if (replay_setup()) {
+		return;
+	}
+
+	// each emulated device owns a main and a debug port
+	int port = TREZOR_UDP_PORT + 2 * emulator_device_index;
+	usb_main.fd = socket_setup(port);
 	usb_main.fromlen = 0;
-	usb_debug.fd = socket_setup(TREZOR_UDP_PORT + 1);
+	usb_debug.fd = socket_setup(port + 1);
 	usb_debug.fromlen = 0;
+
+	stream_setup();
+
+	wake_setup(rx_wake);
+	wake_setup(tx_wake);
+
+	pthread_t thread;
+	if (pthread_create(&thread, NULL, socket_thread, NULL) != 0) {
+		perror("Failed to start socket thread");
+		exit(1);
+	}
+	pthread_detach(thread);
 }
 
 size_t emulatorSocketRead(int *iface, void *buffer, size_t size) {
-	size_t n = socket_read(&usb_main, buffer, size);
-	if (n > 0) {
-		*iface = 0;
-		return n;
+	struct usb_report report;
+	if (!ring_pop(&rx_ring, &report)) {
+		uint32_t len = atomic_load_explicit(&stream_frame_len, memory_order_acquire);
+		if (len == 0) {
+			return 0;
+		}
+		if (len <= size) {
+			memcpy(buffer, stream_frame, len);
+			*iface = 2;
+		} else {
+			len = 0;
+		}
+		atomic_store_explicit(&stream_frame_len, 0, memory_order_release);
+		wake(tx_wake[1]);
+		if (len > 0) {
+			emulatorTraceRecord(false, 2, buffer, len);
+		}
+		return len;
 	}
 
-	n = socket_read(&usb_debug, buffer, size);
-	if (n > 0) {
-		*iface = 1;
-		return n;
+	size_t n = report.len < size ? report.len : size;
+	memcpy(buffer, report.data, n);
+	*iface = report.iface;
+	emulatorTraceRecord(false, report.iface, buffer, n);
+	return n;
+}
+
+size_t emulatorSocketWrite(int iface, const void *buffer, size_t size) {
+	if (iface < 0 || iface > 2 || size > sizeof(((struct usb_report *) 0)->data)) {
+		return 0;
+	}
+
+	emulatorTraceRecord(true, iface, buffer, size);
+
+	struct usb_report report;
+	report.iface = iface;
+	report.len = size;
+	memcpy(report.data, buffer, size);
+
+	while (!ring_push(&tx_ring, &report)) {
+		// the I/O thread is behind, give it time to drain
+		replay_exit_poll();
+		wake(tx_wake[1]);
+		poll(NULL, 0, 1);
 	}
+	wake(tx_wake[1]);
 
-	return 0;
+	return size;
 }
 
-size_t emulatorSocketWrite(int iface, const void *buffer, size_t size) {
-	if (iface == 0) {
-		return socket_write(&usb_main, buffer, size);
+void emulatorSocketWait(uint32_t timeout) {
+	struct pollfd fds[1] = {
+		{ .fd = rx_wake[0], .events = POLLIN },
+	};
+
+	wake_drain(rx_wake[0]);
+	replay_exit_poll();
+	if (ring_count(&rx_ring) > 0 || atomic_load_explicit(&stream_frame_len, memory_order_acquire) != 0) {
+		return;
+	}
+
+	// the firmware is idle, a good time to get the trace to disk
+	emulatorTraceFlush();
+
+#if !HEADLESS
+	if (timeout > EMULATOR_EVENT_INTERVAL) {
+		timeout = EMULATOR_EVENT_INTERVAL;
 	}
-	if (iface == 1) {
-		return socket_write(&usb_debug, buffer, size);
+#endif
+
+	int ms = (timeout > INT_MAX) ? -1 : (int) timeout;
+	if (poll(fds, 1, ms) < 0 && errno != EINTR) {
+		perror("Failed to poll socket");
 	}
-	return 0;
 }
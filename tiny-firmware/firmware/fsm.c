@@ -43,6 +43,9 @@
 #include "skycoin_crypto.h"
 #include "skycoin_check_signature.h"
 #include "check_digest.h"
+#include "memzero.h"
+#include "timer.h"
+#include "perf.h"
 
 // message methods
 
@@ -84,6 +87,57 @@ static uint8_t msg_resp[MSG_OUT_SIZE] __attribute__ ((aligned));
 		return; \
 	}
 
+// interval between two progress updates of a long running handler
+#define FSM_YIELD_INTERVAL_MS 250
+
+static struct {
+	const char *desc;
+	bool notify;
+	uint32_t last_ms;
+} fsm_progress;
+
+void fsm_yieldInit(const char *desc, bool notify)
+{
+	fsm_progress.desc = desc;
+	fsm_progress.notify = notify;
+	fsm_progress.last_ms = timer_ms();
+	// drop tiny messages received before the handler started
+	msg_tiny_id = 0xFFFF;
+}
+
+bool fsm_yield(uint32_t done, uint32_t total)
+{
+	// the handler still owns the decoded request and the half built response
+	// in msg_resp, only tiny messages can be read and none may be answered
+	char oldTiny = usbTiny(1);
+	msg_tiny_quiet = true;
+	usbPoll();
+	msg_tiny_quiet = false;
+	usbTiny(oldTiny);
+
+	if (msg_tiny_id == MessageType_MessageType_Cancel || msg_tiny_id == MessageType_MessageType_Initialize) {
+		if (msg_tiny_id == MessageType_MessageType_Initialize) {
+			protectAbortedByInitialize = true;
+		}
+		msg_tiny_id = 0xFFFF;
+		return false;
+	}
+
+	uint32_t now = timer_ms();
+	if (total > 0 && now - fsm_progress.last_ms >= FSM_YIELD_INTERVAL_MS) {
+		fsm_progress.last_ms = now;
+		layoutProgressSwipe(fsm_progress.desc, (uint64_t)done * 1000 / total);
+		if (fsm_progress.notify) {
+			Progress resp;
+			memset(&resp, 0, sizeof(Progress));
+			resp.done = done;
+			resp.total = total;
+			msg_write(MessageType_MessageType_Progress, &resp);
+		}
+	}
+	return true;
+}
+
 void fsm_sendSuccess(const char *text)
 {
 	RESP_INIT(Success);
@@ -302,34 +356,105 @@ void fsm_msgSkycoinCheckMessageSignature(SkycoinCheckMessageSignature* msg)
 	layoutHome();
 }
 
-int fsm_getKeyPairAtIndex(uint32_t nbAddress, uint8_t* pubkey, uint8_t* seckey, ResponseSkycoinAddress* respSkycoinAddress, uint32_t start_index)
+/* Derives nbAddress consecutive key pairs of the deterministic key chain
+ * starting at start_index.  pubkey and seckey hold the key pair of the last
+ * derived address and, if addresses is not NULL, the base58 address of every
+ * derived key pair is appended to it.
+ * The walk resumes from the session chain cursor whenever the cursor is not
+ * past start_index, otherwise from the session chain head past address 0, and
+ * leaves the cursor on the address following the last one.
+ * The public keys it derives are added to the address cache, written once
+ * the walk ends.
+ * Returns -1 on invalid arguments and -2 if the host cancelled the walk.
+ */
+static int fsm_walkKeyChain(uint32_t start_index, uint32_t nbAddress, uint8_t* pubkey, uint8_t* seckey, char (*addresses)[36], pb_size_t* addresses_count)
 {
-    const char* mnemo = storage_getFullSeed();
-    uint8_t seed[33] = {0};
-    uint8_t nextSeed[SHA256_DIGEST_LENGTH] = {0};
-	size_t size_address = 36;
-    if (mnemo == NULL || nbAddress == 0)
-    {
-        return -1;
-    }
-	generate_deterministic_key_pair_iterator((const uint8_t *)mnemo, strlen(mnemo), nextSeed, seckey, pubkey);
-	if (respSkycoinAddress != NULL && start_index == 0) {
-		generate_base58_address_from_pubkey(pubkey, respSkycoinAddress->addresses[0], &size_address);
-		respSkycoinAddress->addresses_count++;
+	uint8_t seed[SHA256_DIGEST_LENGTH] = {0};
+	uint8_t nextSeed[SHA256_DIGEST_LENGTH] = {0};
+	uint32_t index = 0;
+	uint32_t first;
+	size_t size_address;
+	int ret = 0;
+	if (nbAddress == 0 || start_index > UINT32_MAX - nbAddress)
+	{
+		return -1;
 	}
-	memcpy(seed, nextSeed, 32);
-	for (uint32_t i = 0; i < nbAddress + start_index - 1; ++i)
+	if (session_getChainCursor(&index, seed) && index <= start_index) {
+		generate_deterministic_key_pair_iterator(seed, sizeof(seed), nextSeed, seckey, pubkey);
+	} else if (start_index > 0 && session_getChainHead(seed)) {
+		index = 1;
+		generate_deterministic_key_pair_iterator(seed, sizeof(seed), nextSeed, seckey, pubkey);
+	} else {
+		const char* mnemo = storage_getFullSeed();
+		if (mnemo == NULL) {
+			return -1;
+		}
+		index = 0;
+		generate_deterministic_key_pair_iterator((const uint8_t *)mnemo, strlen(mnemo), nextSeed, seckey, pubkey);
+		session_cacheChainHead(nextSeed);
+	}
+	first = index;
+	for (;;)
 	{
-		generate_deterministic_key_pair_iterator(seed, 32, nextSeed, seckey, pubkey);
-		memcpy(seed, nextSeed, 32);
-		seed[32] = 0;
-		if (respSkycoinAddress != NULL && ((i + 1) >= start_index)) {
+		storage_cachePubkey(index, pubkey);
+		if (addresses != NULL && index >= start_index) {
 			size_address = 36;
-			generate_base58_address_from_pubkey(pubkey, respSkycoinAddress->addresses[respSkycoinAddress->addresses_count], &size_address);
-			respSkycoinAddress->addresses_count++;
+			generate_base58_address_from_pubkey(pubkey, addresses[*addresses_count], &size_address);
+			(*addresses_count)++;
+		}
+		memcpy(seed, nextSeed, sizeof(seed));
+		index++;
+		if (index == start_index + nbAddress) {
+			break;
 		}
+		if (!fsm_yield(index - first, start_index + nbAddress - first)) {
+			ret = -2;
+			break;
+		}
+		generate_deterministic_key_pair_iterator(seed, sizeof(seed), nextSeed, seckey, pubkey);
+	}
+	storage_flushAddressCache();
+	// seed derives the address following the last one, keep it so that
+	// even a cancelled walk is resumed from where it stopped
+	session_cacheChainCursor(index, seed);
+	memzero(seed, sizeof(seed));
+	memzero(nextSeed, sizeof(nextSeed));
+	return ret;
+}
+
+/* Fills addresses from the address cache if all nbAddress public keys from
+ * start_index on are cached, leaving pubkey on the last one.
+ */
+static bool fsm_cachedAddresses(uint32_t start_index, uint32_t nbAddress, uint8_t* pubkey, char (*addresses)[36], pb_size_t* addresses_count)
+{
+	size_t size_address;
+	if (nbAddress == 0 || start_index > UINT32_MAX - nbAddress) {
+		return false;
+	}
+	const pb_size_t count = *addresses_count;
+	for (uint32_t i = 0; i < nbAddress; i++) {
+		if (!storage_getCachedPubkey(start_index + i, pubkey)) {
+			*addresses_count = count;
+			return false;
+		}
+		size_address = 36;
+		generate_base58_address_from_pubkey(pubkey, addresses[*addresses_count], &size_address);
+		(*addresses_count)++;
 	}
-    return 0;
+	return true;
+}
+
+int fsm_getKeyPairAtIndex(uint32_t nbAddress, uint8_t* pubkey, uint8_t* seckey, ResponseSkycoinAddress* respSkycoinAddress, uint32_t start_index)
+{
+	if (respSkycoinAddress != NULL) {
+		// addresses only need the public keys
+		if (fsm_cachedAddresses(start_index, nbAddress, pubkey, respSkycoinAddress->addresses, &respSkycoinAddress->addresses_count)) {
+			memzero(seckey, 32);
+			return 0;
+		}
+		return fsm_walkKeyChain(start_index, nbAddress, pubkey, seckey, respSkycoinAddress->addresses, &respSkycoinAddress->addresses_count);
+	}
+	return fsm_walkKeyChain(start_index, nbAddress, pubkey, seckey, NULL, NULL);
 }
 
 void fsm_msgSkycoinSignMessage(SkycoinSignMessage* msg)
@@ -350,7 +475,18 @@ void fsm_msgSkycoinSignMessage(SkycoinSignMessage* msg)
 	CHECK_PIN_UNCACHED
 
 	RESP_INIT(ResponseSkycoinSignMessage);
-    fsm_getKeyPairAtIndex(1, pubkey, seckey, NULL, msg->address_n);
+	fsm_yieldInit(_("Deriving key"), msg->has_progress && msg->progress);
+	res = fsm_getKeyPairAtIndex(1, pubkey, seckey, NULL, msg->address_n);
+	if (res == -2) {
+		fsm_sendFailure(FailureType_Failure_ActionCancelled, NULL);
+		layoutHome();
+		return;
+	}
+	if (res != 0) {
+		fsm_sendFailure(FailureType_Failure_AddressGeneration, "Key pair generation failed");
+		layoutHome();
+		return;
+	}
 	if (is_digest(msg->message) == false) {
     	compute_sha256sum((const uint8_t *)msg->message, digest, strlen(msg->message));
 	} else {
@@ -391,7 +527,14 @@ void fsm_msgSkycoinAddress(SkycoinAddress* msg)
 		return;
 	}
 
-	if (fsm_getKeyPairAtIndex(msg->address_n, pubkey, seckey, resp, start_index) != 0) 
+	fsm_yieldInit(_("Generating addresses"), msg->has_progress && msg->progress);
+	int res = fsm_getKeyPairAtIndex(msg->address_n, pubkey, seckey, resp, start_index);
+	if (res == -2) {
+		fsm_sendFailure(FailureType_Failure_ActionCancelled, NULL);
+		layoutHome();
+		return;
+	}
+	if (res != 0)
 	{
 		fsm_sendFailure(FailureType_Failure_AddressGeneration, "Key pair generation failed");
 		return;
@@ -409,6 +552,56 @@ void fsm_msgSkycoinAddress(SkycoinAddress* msg)
 	layoutHome();
 }
 
+void fsm_msgSkycoinAddressRange(SkycoinAddressRange* msg)
+{
+	uint8_t seckey[32] = {0};
+	uint8_t pubkey[33] = {0};
+	uint32_t start_index = !msg->has_start_index ? 0 : msg->start_index;
+
+	CHECK_PIN
+
+	RESP_INIT(ResponseSkycoinAddressRange);
+	if (msg->address_n == 0 || msg->address_n > 99) {
+		fsm_sendFailure(FailureType_Failure_AddressGeneration, "Asking for too much addresses");
+		return;
+	}
+
+	if (storage_hasMnemonic() == false) {
+		fsm_sendFailure(FailureType_Failure_AddressGeneration, "Mnemonic not set");
+		return;
+	}
+
+	if (msg->has_continuation) {
+		if (!session_checkChainCursorToken(msg->continuation.bytes, msg->continuation.size)) {
+			fsm_sendFailure(FailureType_Failure_DataError, _("Continuation token expired"));
+			return;
+		}
+		// the token carries the index the cursor is sitting on
+		start_index = ((uint32_t)msg->continuation.bytes[4] << 24) | ((uint32_t)msg->continuation.bytes[5] << 16)
+			| ((uint32_t)msg->continuation.bytes[6] << 8) | msg->continuation.bytes[7];
+	}
+
+	fsm_yieldInit(_("Generating addresses"), msg->has_progress && msg->progress);
+	int res = fsm_walkKeyChain(start_index, msg->address_n, pubkey, seckey, resp->addresses, &resp->addresses_count);
+	if (res == -2) {
+		fsm_sendFailure(FailureType_Failure_ActionCancelled, NULL);
+		layoutHome();
+		return;
+	}
+	if (res != 0)
+	{
+		fsm_sendFailure(FailureType_Failure_AddressGeneration, "Key pair generation failed");
+		return;
+	}
+	memzero(seckey, sizeof(seckey));
+	resp->start_index = start_index;
+	resp->has_continuation = true;
+	resp->continuation.size = SESSION_CHAIN_TOKEN_LEN;
+	session_getChainCursorToken(resp->continuation.bytes);
+	msg_write(MessageType_MessageType_ResponseSkycoinAddressRange, resp);
+	layoutHome();
+}
+
 void fsm_msgPing(Ping *msg)
 {
 	RESP_INIT(Success);
@@ -686,3 +879,134 @@ void fsm_msgEntropyAck(EntropyAck *msg)
 		reset_entropy(0, 0);
 	}
 }
+
+#if DEBUG_LINK
+
+// failures of debug link requests go back on the debug link
+static void fsm_sendDebugFailure(FailureType code, const char *text)
+{
+	Failure resp;
+	memset(&resp, 0, sizeof(resp));
+	resp.has_code = true;
+	resp.code = code;
+	resp.has_message = true;
+	strlcpy(resp.message, text, sizeof(resp.message));
+	msg_debug_write(MessageType_MessageType_Failure, &resp);
+}
+
+void fsm_msgDebugLinkGetState(DebugLinkGetState *msg)
+{
+	(void)msg;
+
+	// Do not use RESP_INIT because it clears msg_resp, but another message
+	// might be being handled
+	DebugLinkState resp;
+	memset(&resp, 0, sizeof(resp));
+
+	resp.has_layout = true;
+	resp.layout.size = OLED_BUFSIZE;
+	memcpy(resp.layout.bytes, oledGetBuffer(), OLED_BUFSIZE);
+
+	if (storage_hasPin()) {
+		resp.has_pin = true;
+		strlcpy(resp.pin, storage_getPin(), sizeof(resp.pin));
+	}
+
+	resp.has_matrix = true;
+	strlcpy(resp.matrix, pinmatrix_get(), sizeof(resp.matrix));
+
+	resp.has_reset_entropy = true;
+	resp.reset_entropy.size = reset_get_int_entropy(resp.reset_entropy.bytes);
+
+	resp.has_reset_word = true;
+	strlcpy(resp.reset_word, reset_get_word(), sizeof(resp.reset_word));
+
+	resp.has_recovery_fake_word = true;
+	strlcpy(resp.recovery_fake_word, recovery_get_fake_word(), sizeof(resp.recovery_fake_word));
+
+	resp.has_recovery_word_pos = true;
+	resp.recovery_word_pos = recovery_get_word_pos();
+
+	if (storage_hasMnemonic()) {
+		resp.has_mnemonic = true;
+		strlcpy(resp.mnemonic, storage_getMnemonic(), sizeof(resp.mnemonic));
+	}
+
+	resp.has_passphrase_protection = true;
+	resp.passphrase_protection = storage_hasPassphraseProtection();
+
+	msg_debug_write(MessageType_MessageType_DebugLinkState, &resp);
+}
+
+void fsm_msgDebugLinkSetClock(DebugLinkSetClock *msg)
+{
+#if EMULATOR
+	if (msg->has_virtual_clock) {
+		emulatorClockSetVirtual(msg->virtual_clock);
+	}
+	if (msg->has_advance) {
+		if (!emulatorClockIsVirtual()) {
+			fsm_sendDebugFailure(FailureType_Failure_DataError, _("Virtual clock is not enabled"));
+			return;
+		}
+		emulatorClockAdvance(msg->advance);
+	}
+
+	DebugLinkClock resp;
+	memset(&resp, 0, sizeof(resp));
+	resp.time_ms = timer_ms();
+	resp.virtual_clock = emulatorClockIsVirtual();
+	msg_debug_write(MessageType_MessageType_DebugLinkClock, &resp);
+#else
+	(void)msg;
+	fsm_sendDebugFailure(FailureType_Failure_UnexpectedMessage, _("Clock control is only available in the emulator"));
+#endif
+}
+
+void fsm_msgDebugLinkSetRandomSeed(DebugLinkSetRandomSeed *msg)
+{
+#if EMULATOR
+	emulatorRandomSeed(msg->seed.bytes, msg->has_seed ? msg->seed.size : 0);
+
+	Success resp;
+	memset(&resp, 0, sizeof(resp));
+	msg_debug_write(MessageType_MessageType_Success, &resp);
+#else
+	(void)msg;
+	fsm_sendDebugFailure(FailureType_Failure_UnexpectedMessage, _("Random seed is only available in the emulator"));
+#endif
+}
+
+// Do not use RESP_INIT because it clears msg_resp, but another message
+// might be being handled. Static as the counters do not fit the stack well.
+static DebugLinkPerfStats perf_resp;
+
+void fsm_msgDebugLinkGetPerfStats(DebugLinkGetPerfStats *msg)
+{
+	(void)msg;
+	memset(&perf_resp, 0, sizeof(perf_resp));
+	perf_stats(&perf_resp);
+	msg_debug_write(MessageType_MessageType_DebugLinkPerfStats, &perf_resp);
+}
+
+void fsm_msgDebugLinkResetPerfStats(DebugLinkResetPerfStats *msg)
+{
+	(void)msg;
+	memset(&perf_resp, 0, sizeof(perf_resp));
+	perf_stats(&perf_resp);
+	perf_reset();
+	msg_debug_write(MessageType_MessageType_DebugLinkPerfStats, &perf_resp);
+}
+
+void fsm_msgDebugLinkGetMemoryStats(DebugLinkGetMemoryStats *msg)
+{
+	DebugLinkMemoryStats resp;
+	memset(&resp, 0, sizeof(resp));
+	perf_memory_stats(&resp);
+	if (msg->has_reset && msg->reset) {
+		perf_stack_paint();
+	}
+	msg_debug_write(MessageType_MessageType_DebugLinkMemoryStats, &resp);
+}
+
+#endif
@@ -28,6 +28,10 @@ void fsm_sendSuccess(const char *text);
 
 void fsm_sendFailure(FailureType code, const char *text);
 
+// cooperative yield point for long running handlers, returns false if the host cancelled
+void fsm_yieldInit(const char *desc, bool notify);
+bool fsm_yield(uint32_t done, uint32_t total);
+
 void fsm_msgInitialize(Initialize *msg);
 void fsm_msgGetFeatures(GetFeatures *msg);
 void fsm_msgApplySettings(ApplySettings *msg);
@@ -35,6 +39,7 @@ int fsm_getKeyPairAtIndex(uint32_t nbAddress, uint8_t* pubkey, uint8_t* seckey,
 void fsm_msgSkycoinCheckMessageSignature(SkycoinCheckMessageSignature* msg);
 void fsm_msgSkycoinSignMessage(SkycoinSignMessage* msg);
 void fsm_msgSkycoinAddress(SkycoinAddress* msg);
+void fsm_msgSkycoinAddressRange(SkycoinAddressRange* msg);
 void fsm_msgGenerateMnemonic(GenerateMnemonic* msg);
 void fsm_msgSetMnemonic(SetMnemonic* msg);
 void fsm_msgPing(Ping *msg);
@@ -51,4 +56,13 @@ void fsm_msgRecoveryDevice(RecoveryDevice *msg);
 void fsm_msgWordAck(WordAck *msg);
 void fsm_msgGetVersion(GetVersion *msg);
 
+#if DEBUG_LINK
+void fsm_msgDebugLinkGetState(DebugLinkGetState *msg);
+void fsm_msgDebugLinkSetClock(DebugLinkSetClock *msg);
+void fsm_msgDebugLinkSetRandomSeed(DebugLinkSetRandomSeed *msg);
+void fsm_msgDebugLinkGetPerfStats(DebugLinkGetPerfStats *msg);
+void fsm_msgDebugLinkResetPerfStats(DebugLinkResetPerfStats *msg);
+void fsm_msgDebugLinkGetMemoryStats(DebugLinkGetMemoryStats *msg);
+#endif
+
 #endif
@@ -24,6 +24,7 @@
 #include "fsm.h"
 #include "util.h"
 #include "gettext.h"
+#include "perf.h"
 
 #include "pb_decode.h"
 #include "pb_encode.h"
@@ -117,6 +118,49 @@ static bool pb_callback_out(pb_ostream_t *stream, const uint8_t *buf, size_t cou
 	return true;
 }
 
+#if DEBUG_LINK
+
+static uint32_t msg_debug_out_start = 0;
+static uint32_t msg_debug_out_end = 0;
+static uint32_t msg_debug_out_cur = 0;
+static uint8_t msg_debug_out[MSG_DEBUG_OUT_SIZE];
+
+static inline void msg_debug_out_append(uint8_t c)
+{
+	if (msg_debug_out_cur == 0) {
+		msg_debug_out[msg_debug_out_end * 64] = '?';
+		msg_debug_out_cur = 1;
+	}
+	msg_debug_out[msg_debug_out_end * 64 + msg_debug_out_cur] = c;
+	msg_debug_out_cur++;
+	if (msg_debug_out_cur == 64) {
+		msg_debug_out_cur = 0;
+		msg_debug_out_end = (msg_debug_out_end + 1) % (MSG_DEBUG_OUT_SIZE / 64);
+	}
+}
+
+static inline void msg_debug_out_pad(void)
+{
+	if (msg_debug_out_cur == 0) return;
+	while (msg_debug_out_cur < 64) {
+		msg_debug_out[msg_debug_out_end * 64 + msg_debug_out_cur] = 0;
+		msg_debug_out_cur++;
+	}
+	msg_debug_out_cur = 0;
+	msg_debug_out_end = (msg_debug_out_end + 1) % (MSG_DEBUG_OUT_SIZE / 64);
+}
+
+static bool pb_debug_callback_out(pb_ostream_t *stream, const uint8_t *buf, size_t count)
+{
+	(void)stream;
+	for (size_t i = 0; i < count; i++) {
+		msg_debug_out_append(buf[i]);
+	}
+	return true;
+}
+
+#endif
+
 bool msg_write_common(char type, uint16_t msg_id, const void *msg_ptr)
 {
 	const pb_field_t *fields = MessageFields(type, 'o', msg_id);
@@ -124,6 +168,7 @@ bool msg_write_common(char type, uint16_t msg_id, const void *msg_ptr)
 		return false;
 	}
 
+	PERF_BEGIN(encode);
 	pb_ostream_t sizestream = {0, 0, SIZE_MAX, 0, 0};
 	bool status = pb_encode(&sizestream, fields, msg_ptr);
 
@@ -138,7 +183,12 @@ bool msg_write_common(char type, uint16_t msg_id, const void *msg_ptr)
 		append = msg_out_append;
 		pb_callback = pb_callback_out;
 	} else
-
+#if DEBUG_LINK
+	if (type == 'd') {
+		append = msg_debug_out_append;
+		pb_callback = pb_debug_callback_out;
+	} else
+#endif
 	{
 		return false;
 	}
@@ -157,6 +207,12 @@ bool msg_write_common(char type, uint16_t msg_id, const void *msg_ptr)
 	if (type == 'n') {
 		msg_out_pad();
 	}
+#if DEBUG_LINK
+	else if (type == 'd') {
+		msg_debug_out_pad();
+	}
+#endif
+	PERF_END(encode, msg_id, PERF_ENCODE);
 	return status;
 }
 
@@ -170,14 +226,28 @@ void msg_process(char type, uint16_t msg_id, const pb_field_t *fields, uint8_t *
 	static CONFIDENTIAL uint8_t msg_data[MSG_IN_SIZE];
 	memset(msg_data, 0, sizeof(msg_data));
 	pb_istream_t stream = pb_istream_from_buffer(msg_raw, msg_size);
+	PERF_BEGIN(decode);
 	bool status = pb_decode(&stream, fields, msg_data);
+	PERF_END(decode, msg_id, PERF_DECODE);
 	if (status) {
+		PERF_BEGIN(handler);
 		MessageProcessFunc(type, 'i', msg_id, msg_data);
+		PERF_END(handler, msg_id, PERF_HANDLER);
 	} else {
 		fsm_sendFailure(FailureType_Failure_DataError, stream.errmsg);
 	}
 }
 
+// copies frame payload, dropping the padding past the end of the message
+static inline void msg_read_append(uint8_t *msg_in, uint32_t *msg_pos, uint32_t msg_size, const uint8_t *data, uint32_t len)
+{
+	if (len > msg_size - *msg_pos) {
+		len = msg_size - *msg_pos;
+	}
+	memcpy(msg_in + *msg_pos, data, len);
+	*msg_pos += len;
+}
+
 void msg_read_common(char type, const uint8_t *buf, int len)
 {
 	static char read_state = READSTATE_IDLE;
@@ -187,10 +257,12 @@ void msg_read_common(char type, const uint8_t *buf, int len)
 	static uint32_t msg_pos = 0;
 	static const pb_field_t *fields = 0;
 
-	if (len != 64) return;
+	// frames are usually 64 byte HID reports, but any size is accepted
+	// so stream transports can pass a whole message at once
+	if (len < 1) return;
 
 	if (read_state == READSTATE_IDLE) {
-		if (buf[0] != '?' || buf[1] != '#' || buf[2] != '#') {	// invalid start - discard
+		if (len < 9 || buf[0] != '?' || buf[1] != '#' || buf[2] != '#') {	// invalid start - discard
 			return;
 		}
 		msg_id = (buf[3] << 8) + buf[4];
@@ -208,16 +280,15 @@ void msg_read_common(char type, const uint8_t *buf, int len)
 
 		read_state = READSTATE_READING;
 
-		memcpy(msg_in, buf + 9, len - 9);
-		msg_pos = len - 9;
+		msg_pos = 0;
+		msg_read_append(msg_in, &msg_pos, msg_size, buf + 9, len - 9);
 	} else
 	if (read_state == READSTATE_READING) {
 		if (buf[0] != '?') {	// invalid contents
 			read_state = READSTATE_IDLE;
 			return;
 		}
-		memcpy(msg_in + msg_pos, buf + 1, len - 1);
-		msg_pos += len - 1;
+		msg_read_append(msg_in, &msg_pos, msg_size, buf + 1, len - 1);
 	}
 
 	if (msg_pos >= msg_size) {
@@ -235,19 +306,32 @@ const uint8_t *msg_out_data(void)
 	return data;
 }
 
+#if DEBUG_LINK
+
+const uint8_t *msg_debug_out_data(void)
+{
+	if (msg_debug_out_start == msg_debug_out_end) return 0;
+	uint8_t *data = msg_debug_out + (msg_debug_out_start * 64);
+	msg_debug_out_start = (msg_debug_out_start + 1) % (MSG_DEBUG_OUT_SIZE / 64);
+	return data;
+}
+
+#endif
+
 
 CONFIDENTIAL uint8_t msg_tiny[64];
 uint16_t msg_tiny_id = 0xFFFF;
+bool msg_tiny_quiet = false;
 
 void msg_read_tiny(const uint8_t *buf, int len)
 {
-	if (len != 64) return;
+	if (len < 9) return;
 	if (buf[0] != '?' || buf[1] != '#' || buf[2] != '#') {
 		return;
 	}
 	uint16_t msg_id = (buf[3] << 8) + buf[4];
 	uint32_t msg_size = (buf[5] << 24) + (buf[6] << 16) + (buf[7] << 8) + buf[8];
-	if (msg_size > 64 || len - msg_size < 9) {
+	if (msg_size > 64 || msg_size > (uint32_t)len - 9) {
 		return;
 	}
 
@@ -271,17 +355,29 @@ void msg_read_tiny(const uint8_t *buf, int len)
 		case MessageType_MessageType_Initialize:
 			fields = Initialize_fields;
 			break;
+#if DEBUG_LINK
+		case MessageType_MessageType_DebugLinkDecision:
+			fields = DebugLinkDecision_fields;
+			break;
+		case MessageType_MessageType_DebugLinkGetState:
+			fields = DebugLinkGetState_fields;
+			break;
+#endif
 	}
 	if (fields) {
 		bool status = pb_decode(&stream, fields, msg_tiny);
 		if (status) {
 			msg_tiny_id = msg_id;
 		} else {
-			fsm_sendFailure(FailureType_Failure_DataError, stream.errmsg);
+			if (!msg_tiny_quiet) {
+				fsm_sendFailure(FailureType_Failure_DataError, stream.errmsg);
+			}
 			msg_tiny_id = 0xFFFF;
 		}
 	} else {
-		fsm_sendFailure(FailureType_Failure_UnexpectedMessage, _("Unknown message read_tiny"));
+		if (!msg_tiny_quiet) {
+			fsm_sendFailure(FailureType_Failure_UnexpectedMessage, _("Unknown message read_tiny"));
+		}
 		msg_tiny_id = 0xFFFF;
 	}
 }
@@ -49,5 +49,7 @@ void msg_read_tiny(const uint8_t *buf, int len);
 void msg_debug_read_tiny(const uint8_t *buf, int len);
 extern uint8_t msg_tiny[64];
 extern uint16_t msg_tiny_id;
+// drop undecodable tiny messages instead of answering them with a Failure
+extern bool msg_tiny_quiet;
 
 #endif
@@ -0,0 +1,200 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <string.h>
+
+#include "perf.h"
+#include "util.h"
+
+#if EMULATOR
+#include <time.h>
+#else
+#include <libopencm3/cm3/dwt.h>
+#endif
+
+// distinct message types tracked, later ones are not counted
+#define PERF_MESSAGES 32
+
+#define PERF_CPU_HZ 120000000
+
+#define PERF_STACK_PATTERN 0xA5A5A5A5
+// left alone below the frame of the painting function
+#define PERF_STACK_MARGIN 256
+#if !EMULATOR
+// end of .bss, defined by the linker script
+extern uint8_t _ebss[];
+#endif
+
+struct perf_counter {
+	uint32_t count;
+	uint64_t total;
+	uint64_t max;
+};
+
+struct perf_message {
+	uint16_t msg_id;
+	struct perf_counter phases[PERF_PHASE_COUNT];
+};
+
+static struct perf_message perf_messages[PERF_MESSAGES];
+static uint8_t perf_message_count;
+
+static struct perf_counter perf_spans[PERF_SPAN_COUNT];
+static perf_ticks perf_span_start[PERF_SPAN_COUNT];
+
+static uint32_t *stack_bottom;
+static uint32_t *stack_top;
+
+static const char * const perf_span_names[PERF_SPAN_COUNT] = {
+	"secp256k1Hash",
+	"scalar_multiply",
+	"base58",
+};
+
+void perf_init(void)
+{
+#if !EMULATOR
+	dwt_enable_cycle_counter();
+	perf_stack_init(_ebss, _ram_end);
+#endif
+	// the emulator stack is set by whoever owns it, see PERF_STACK_PAINT
+	perf_reset();
+}
+
+void perf_reset(void)
+{
+	memset(perf_messages, 0, sizeof(perf_messages));
+	perf_message_count = 0;
+	memset(perf_spans, 0, sizeof(perf_spans));
+}
+
+perf_ticks perf_now(void)
+{
+#if EMULATOR
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+#else
+	return dwt_read_cycle_counter();
+#endif
+}
+
+static void perf_count(struct perf_counter *counter, perf_ticks begin)
+{
+	// unsigned difference survives one wrap of the 32 bit cycle counter
+	perf_ticks elapsed = perf_now() - begin;
+	counter->count++;
+	counter->total += elapsed;
+	if (elapsed > counter->max) {
+		counter->max = elapsed;
+	}
+}
+
+void perf_record(uint16_t msg_id, perf_phase phase, perf_ticks begin)
+{
+	uint8_t i;
+	for (i = 0; i < perf_message_count; i++) {
+		if (perf_messages[i].msg_id == msg_id) {
+			break;
+		}
+	}
+	if (i == perf_message_count) {
+		if (perf_message_count == PERF_MESSAGES) {
+			return;
+		}
+		perf_messages[i].msg_id = msg_id;
+		perf_message_count++;
+	}
+	perf_count(&perf_messages[i].phases[phase], begin);
+}
+
+void perf_span_begin(perf_span span)
+{
+	perf_span_start[span] = perf_now();
+}
+
+void perf_span_end(perf_span span)
+{
+	perf_count(&perf_spans[span], perf_span_start[span]);
+}
+
+static bool perf_fill(PerfCounterType *out, const struct perf_counter *counter)
+{
+	out->count = counter->count;
+	out->total = counter->total;
+	out->max = counter->max;
+	return counter->count > 0;
+}
+
+void perf_stats(DebugLinkPerfStats *stats)
+{
+#if EMULATOR
+	stats->tick_hz = 1000000000;
+#else
+	stats->tick_hz = PERF_CPU_HZ;
+#endif
+
+	stats->messages_count = perf_message_count;
+	for (uint8_t i = 0; i < perf_message_count; i++) {
+		PerfMessageType *msg = &stats->messages[i];
+		msg->message_type = perf_messages[i].msg_id;
+		msg->has_decode = perf_fill(&msg->decode, &perf_messages[i].phases[PERF_DECODE]);
+		msg->has_handler = perf_fill(&msg->handler, &perf_messages[i].phases[PERF_HANDLER]);
+		msg->has_encode = perf_fill(&msg->encode, &perf_messages[i].phases[PERF_ENCODE]);
+	}
+
+	stats->spans_count = PERF_SPAN_COUNT;
+	for (int i = 0; i < PERF_SPAN_COUNT; i++) {
+		strlcpy(stats->spans[i].name, perf_span_names[i], sizeof(stats->spans[i].name));
+		perf_fill(&stats->spans[i].counter, &perf_spans[i]);
+	}
+}
+
+void perf_stack_init(void *bottom, void *top)
+{
+	stack_bottom = (uint32_t *)(((uintptr_t)bottom + 3) & ~(uintptr_t)3);
+	stack_top = (uint32_t *)((uintptr_t)top & ~(uintptr_t)3);
+	perf_stack_paint();
+}
+
+void perf_stack_paint(void)
+{
+	// only paint below the running code when it is on the painted stack
+	volatile uint32_t *limit = stack_top;
+	uint32_t *frame = (uint32_t *)((uintptr_t)__builtin_frame_address(0) - PERF_STACK_MARGIN);
+	if (frame > stack_bottom && frame < stack_top) {
+		limit = frame;
+	}
+	for (volatile uint32_t *p = stack_bottom; p < limit; p++) {
+		*p = PERF_STACK_PATTERN;
+	}
+}
+
+void perf_memory_stats(DebugLinkMemoryStats *stats)
+{
+	const volatile uint32_t *p = stack_bottom;
+	while (p < stack_top && *p == PERF_STACK_PATTERN) {
+		p++;
+	}
+
+	stats->stack_size = (stack_top - stack_bottom) * sizeof(uint32_t);
+	stats->stack_used = (stack_top - p) * sizeof(uint32_t);
+#if !EMULATOR
+	stats->has_static_size = true;
+	stats->static_size = _ebss - _ram_start;
+#endif
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PERF_H__
+#define __PERF_H__
+
+#include <stdint.h>
+
+#include "perf_span.h"
+
+/*
+ * Per message type and per crypto primitive timing for debug link builds.
+ * Ticks are CPU cycles (DWT CYCCNT) on the device and nanoseconds in the
+ * emulator. Without DEBUG_LINK the macros below compile to nothing.
+ *
+ * The free stack is painted with a pattern as well, the lowest overwritten
+ * word gives the stack high-water mark.
+ */
+typedef enum {
+	PERF_DECODE,
+	PERF_HANDLER,
+	PERF_ENCODE,
+	PERF_PHASE_COUNT,
+} perf_phase;
+
+#if DEBUG_LINK
+
+#include "messages.pb.h"
+
+#if EMULATOR
+typedef uint64_t perf_ticks;
+#else
+typedef uint32_t perf_ticks;
+#endif
+
+void perf_init(void);
+void perf_reset(void);
+perf_ticks perf_now(void);
+void perf_record(uint16_t msg_id, perf_phase phase, perf_ticks begin);
+void perf_stats(DebugLinkPerfStats *stats);
+
+#if EMULATOR
+// the host stack of the standalone emulator has no fixed end, main paints
+// this much below its frame; libskyemu paints its own firmware stack
+#define PERF_STACK_PAINT (128 * 1024)
+#endif
+
+void perf_stack_init(void *bottom, void *top);
+void perf_stack_paint(void);
+void perf_memory_stats(DebugLinkMemoryStats *stats);
+
+#define PERF_BEGIN(var) perf_ticks var = perf_now()
+#define PERF_END(var, msg_id, phase) perf_record((msg_id), (phase), var)
+
+#else
+
+#define PERF_BEGIN(var)
+#define PERF_END(var, msg_id, phase)
+
+#endif
+
+#endif
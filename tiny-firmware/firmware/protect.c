@@ -102,6 +102,11 @@ bool protectButton(ButtonRequestType type, bool confirm_only)
 			fsm_msgDebugLinkGetState((DebugLinkGetState *)msg_tiny);
 		}
 #endif
+
+		// until acked there is nothing to do but wait for the host
+		if (!acked) {
+			usbIdle(USB_IDLE_FOREVER);
+		}
 	}
 
 	usbTiny(0);
@@ -142,6 +147,7 @@ const char *requestPin(PinMatrixRequestType type, const char *text)
 			fsm_msgDebugLinkGetState((DebugLinkGetState *)msg_tiny);
 		}
 #endif
+		usbIdle(USB_IDLE_FOREVER);
 	}
 }
 
@@ -269,6 +275,7 @@ bool protectPassphrase(void)
 			result = false;
 			break;
 		}
+		usbIdle(USB_IDLE_FOREVER);
 	}
 	usbTiny(0);
 	layoutHome();
@@ -500,16 +500,7 @@ static void recovery_scrambledword(const char *word)
 		}
 	} else { // real word
 		if (enforce_wordlist) { // check if word is valid
-			const char * const *wl = mnemonic_wordlist();
-			bool found = false;
-			while (*wl) {
-				if (strcmp(word, *wl) == 0) {
-					found = true;
-					break;
-				}
-				wl++;
-			}
-			if (!found) {
+			if (mnemonic_find_word(word) < 0) {
 				if (!dry_run) {
 					session_clear(true);
 				}
@@ -0,0 +1,300 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <ucontext.h>
+
+#include "skyemu.h"
+#include "usb.h"
+
+#include "messages.h"
+#include "trezor.h"
+#include "perf.h"
+
+/*
+ * USB layer of libskyemu, linked instead of udp.c. The firmware main loop
+ * runs on its own stack and hands control back to emu_step() wherever it
+ * would otherwise wait: usbIdle() with nothing in flight and usbSleep(),
+ * which only advances the virtual clock. Handlers blocked on a ButtonAck or
+ * PinMatrixAck therefore simply resume on a later emu_step().
+ */
+
+#define EMU_QUEUE_SIZE (64 * 1024)
+#define EMU_STACK_SIZE (256 * 1024)
+
+// records of length (4) + bytes
+struct emu_queue {
+	uint8_t data[EMU_QUEUE_SIZE];
+	uint32_t start;
+	uint32_t end;
+	uint32_t count;
+};
+
+// rebuilds whole messages from 64 byte reports, as interface, id and payload
+struct emu_assembler {
+	char iface;
+	uint8_t msg[3 + MSG_OUT_SIZE];
+	uint32_t size;
+	uint32_t pos;
+	bool active;
+};
+
+static struct emu_queue emu_in;
+static struct emu_queue emu_out;
+static struct emu_assembler emu_out_main = { .iface = EMU_IFACE_MAIN };
+#if DEBUG_LINK
+static struct emu_assembler emu_out_debug = { .iface = EMU_IFACE_DEBUG };
+#endif
+// a reply did not fit in emu_out since the last emu_step
+static bool emu_out_lost = false;
+
+static ucontext_t host_context;
+static ucontext_t firmware_context;
+static uint8_t firmware_stack[EMU_STACK_SIZE];
+static bool in_firmware = false;
+
+static volatile char tiny = 0;
+static bool pending = false;
+
+static bool queue_push(struct emu_queue *q, const uint8_t *head, uint32_t head_len, const uint8_t *data, uint32_t len)
+{
+	uint32_t total = head_len + len;
+	if (q->end + 4 + total > sizeof(q->data)) {
+		memmove(q->data, q->data + q->start, q->end - q->start);
+		q->end -= q->start;
+		q->start = 0;
+		if (q->end + 4 + total > sizeof(q->data)) {
+			return false;
+		}
+	}
+
+	memcpy(q->data + q->end, &total, 4);
+	memcpy(q->data + q->end + 4, head, head_len);
+	memcpy(q->data + q->end + 4 + head_len, data, len);
+	q->end += 4 + total;
+	q->count++;
+	return true;
+}
+
+static const uint8_t *queue_peek(const struct emu_queue *q, uint32_t *len)
+{
+	if (q->count == 0) {
+		return NULL;
+	}
+	memcpy(len, q->data + q->start, 4);
+	return q->data + q->start + 4;
+}
+
+static void queue_drop(struct emu_queue *q)
+{
+	uint32_t len;
+	memcpy(&len, q->data + q->start, 4);
+	q->start += 4 + len;
+	q->count--;
+	if (q->count == 0) {
+		q->start = q->end = 0;
+	}
+}
+
+static void assemble(struct emu_assembler *a, const uint8_t *report)
+{
+	const uint8_t *data = report + 1;
+	uint32_t len = 63;
+
+	if (!a->active) {
+		if (report[0] != '?' || report[1] != '#' || report[2] != '#') {
+			return;
+		}
+		a->msg[0] = a->iface;
+		a->msg[1] = report[3];
+		a->msg[2] = report[4];
+		a->size = ((uint32_t) report[5] << 24) + (report[6] << 16) + (report[7] << 8) + report[8];
+		a->pos = 0;
+		a->active = true;
+		data = report + 9;
+		len = 55;
+	}
+
+	if (len > a->size - a->pos) {
+		len = a->size - a->pos;
+	}
+	if (a->pos + len <= sizeof(a->msg) - 3) {
+		memcpy(a->msg + 3 + a->pos, data, len);
+	}
+	a->pos += len;
+
+	if (a->pos >= a->size) {
+		a->active = false;
+		if (a->size > sizeof(a->msg) - 3 || !queue_push(&emu_out, a->msg, 3 + a->size, NULL, 0)) {
+			emu_out_lost = true;
+		}
+	}
+}
+
+static void emu_yield(void)
+{
+	if (in_firmware) {
+		swapcontext(&firmware_context, &host_context);
+	}
+}
+
+static void firmware_main(void)
+{
+	for (;;) {
+		trezor_loop();
+	}
+}
+
+void usbInit(void)
+{
+}
+
+void usbPoll(void)
+{
+	static uint8_t frame[EMULATOR_FRAME_MAX];
+
+	pending = false;
+
+	uint32_t len;
+	const uint8_t *data = queue_peek(&emu_in, &len);
+	if (data != NULL) {
+		pending = true;
+		// records are the interface and a whole frame
+		char iface = data[0];
+		memcpy(frame, data + 1, len - 1);
+		queue_drop(&emu_in);
+		if (!tiny) {
+			msg_read_common(iface, frame, len - 1);
+		} else {
+			msg_read_tiny(frame, len - 1);
+		}
+	}
+
+	while ((data = msg_out_data()) != NULL) {
+		pending = true;
+		assemble(&emu_out_main, data);
+	}
+
+#if DEBUG_LINK
+	while ((data = msg_debug_out_data()) != NULL) {
+		pending = true;
+		assemble(&emu_out_debug, data);
+	}
+#endif
+}
+
+char usbTiny(char set)
+{
+	char old = tiny;
+	tiny = set;
+	return old;
+}
+
+void usbIdle(uint32_t millis)
+{
+	(void)millis;
+	if (!pending) {
+		emu_yield();
+	}
+}
+
+void usbSleep(uint32_t millis)
+{
+	do {
+		usbPoll();
+	} while (pending);
+	emulatorClockAdvance(millis);
+
+	if (emu_in.count == 0) {
+		emu_yield();
+	}
+}
+
+void emu_init(const char *flash_image)
+{
+	emulatorSetFlashImage(flash_image);
+	trezor_init();
+	// sleeps must not cost wall-clock time in process
+	emulatorClockSetVirtual(true);
+#if DEBUG_LINK
+	// the high-water mark is about the firmware stack, the host one is never painted
+	perf_stack_init(firmware_stack, firmware_stack + sizeof(firmware_stack));
+#endif
+
+	getcontext(&firmware_context);
+	firmware_context.uc_stack.ss_sp = firmware_stack;
+	firmware_context.uc_stack.ss_size = sizeof(firmware_stack);
+	firmware_context.uc_link = NULL;
+	makecontext(&firmware_context, firmware_main, 0);
+}
+
+bool emu_send(char iface, uint16_t msg_id, const uint8_t *data, uint32_t len)
+{
+#if DEBUG_LINK
+	if (iface != EMU_IFACE_MAIN && iface != EMU_IFACE_DEBUG) {
+		return false;
+	}
+#else
+	if (iface != EMU_IFACE_MAIN) {
+		return false;
+	}
+#endif
+	if (len > EMULATOR_FRAME_MAX - 9) {
+		return false;
+	}
+
+	const uint8_t head[10] = {
+		iface,
+		'?', '#', '#',
+		(msg_id >> 8) & 0xFF, msg_id & 0xFF,
+		(len >> 24) & 0xFF, (len >> 16) & 0xFF, (len >> 8) & 0xFF, len & 0xFF,
+	};
+	return queue_push(&emu_in, head, sizeof(head), data, len);
+}
+
+int emu_step(void)
+{
+	in_firmware = true;
+	swapcontext(&host_context, &firmware_context);
+	in_firmware = false;
+
+	if (emu_out_lost) {
+		emu_out_lost = false;
+		return -1;
+	}
+	return emu_out.count;
+}
+
+int emu_recv(char *iface, uint16_t *msg_id, uint8_t *data, uint32_t size)
+{
+	uint32_t len;
+	const uint8_t *msg = queue_peek(&emu_out, &len);
+	if (msg == NULL) {
+		return -1;
+	}
+	if (len - 3 > size) {
+		return -2;
+	}
+
+	*iface = msg[0];
+	*msg_id = (msg[1] << 8) + msg[2];
+	memcpy(data, msg + 3, len - 3);
+	queue_drop(&emu_out);
+	return len - 3;
+}
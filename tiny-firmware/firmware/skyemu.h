@@ -0,0 +1,51 @@
+/*
+ * This file is part of the TREZOR project, https://trezor.io/
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this library.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SKYEMU_H__
+#define __SKYEMU_H__
+
+/*
+ * libskyemu: the emulator firmware as an in-process library. Messages are
+ * passed as protobuf payloads with their wire id, there is no transport.
+ * The firmware keeps global state, so there is one device per process.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// interfaces of emu_send and emu_recv, the debug link needs DEBUG_LINK=1
+#define EMU_IFACE_MAIN  'n'
+#define EMU_IFACE_DEBUG 'd'
+
+// start the firmware on flash_image, NULL keeps the flash in memory only
+void emu_init(const char *flash_image);
+
+// queue a message for the firmware on iface, false if the input queue is
+// full, the message too large or iface not available in this build
+bool emu_send(char iface, uint16_t msg_id, const uint8_t *data, uint32_t len);
+
+// run the firmware until it waits for input or sleeps, returns the
+// number of replies ready for emu_recv, or -1 if replies were dropped
+// since the last call because the output queue was full
+int emu_step(void);
+
+// pop the next reply of either interface into iface, msg_id and data,
+// returns its length, -1 if there is none and -2 if it does not fit in
+// size bytes
+int emu_recv(char *iface, uint16_t *msg_id, uint8_t *data, uint32_t size);
+
+#endif
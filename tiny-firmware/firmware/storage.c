@@ -51,7 +51,12 @@ Storage CONFIDENTIAL storageUpdate __attribute__((aligned(4)));
 _Static_assert((sizeof(storageUpdate) & 3) == 0, "storage unaligned");
 
 #define FLASH_STORAGE (FLASH_STORAGE_START + sizeof(storage_magic) + sizeof(storage_uuid))
-#define storageRom ((const Storage *) FLASH_PTR(FLASH_STORAGE))
+
+/* Committed storage: the Storage image in flash with the record log
+ * replayed on top of it, see storage_log_replay().
+ */
+static Storage CONFIDENTIAL storageShadow __attribute__((aligned(4)));
+#define storageRom ((const Storage *) &storageShadow)
 
 char storage_uuid_str[25];
 
@@ -63,10 +68,11 @@ char storage_uuid_str[25];
  0x0000 |     4 bytes  |  magic = 'stor'
  0x0004 |    12 bytes  |  uuid
  0x0010 |     ? bytes  |  Storage structure
+ 0x1000 |    12 kbytes |  record log of Storage changes
 --------+--------------+-------------------------------
  0x4000 |     4 kbytes |  area for pin failures
  0x5000 |   256 bytes  |  area for u2f counter updates
- 0x5100 | 11.75 kbytes |  reserved
+ 0x5100 | 11.75 kbytes |  address cache
 
 The area for pin failures looks like this:
 0 ... 0 pinfail 0xffffffff .. 0xffffffff
@@ -80,6 +86,32 @@ followed by a sequence of one-bits.  The bits in a byte are numbered
 from LSB to MSB.  The number of zero bits is the offset that should
 be added to the storage u2f_counter to get the real counter value.
 
+The record log holds the changes made since the Storage structure was
+last written.  Each record replaces a run of words of the structure:
+
+header = STORAGE_LOG_TAG | word offset << 12 | word count
+data   = word count words
+commit = ~header
+
+The commit word is programmed last, so a record torn by a power loss is
+never replayed.  The log ends at the first erased word; anything else
+that is not a complete record closes the log and the next change writes
+a fresh Storage structure, which is also done when the log is full.
+The log is only replayed on a structure of storage version 10 or later.
+
+The address cache keeps the public keys of the first addresses of the
+wallet so that they are not derived again after a reboot.  It is a log
+of records like the one above:
+
+wallet = ADDRCACHE_WALLET, sha256 fingerprint of the full seed, commit
+pubkey = ADDRCACHE_PUBKEY | index, compressed public key, commit
+
+A public key belongs to the wallet record before it and is only used
+while the fingerprint matches the current seed.  Clearing the commit word
+of the last wallet record drops it with all its keys.  The cache is
+erased with the pin area, and recycled with it when it is full or torn,
+starting again with the current wallet.
+
  */
 
 #define FLASH_STORAGE_PINAREA     (FLASH_META_START + 0x4000)
@@ -87,11 +119,52 @@ be added to the storage u2f_counter to get the real counter value.
 #define FLASH_STORAGE_U2FAREA     (FLASH_STORAGE_PINAREA + FLASH_STORAGE_PINAREA_LEN)
 #define FLASH_STORAGE_U2FAREA_LEN (0x100)
 #define FLASH_STORAGE_REALLEN     (sizeof(storage_magic) + sizeof(storage_uuid) + sizeof(Storage))
+#define FLASH_STORAGE_LOG         (FLASH_META_START + 0x1000)
+#define FLASH_STORAGE_LOG_END     (FLASH_STORAGE_PINAREA)
+
+#define STORAGE_LOG_TAG           0x6c000000  // 'l'
+#define STORAGE_LOG_TAG_MASK      0xff000000
+#define STORAGE_LOG_WORDS         (sizeof(Storage) / sizeof(uint32_t))
+#define STORAGE_LOG_VERSION       10  // first storage version with a record log
+
+#define FLASH_STORAGE_ADDRCACHE     (FLASH_STORAGE_U2FAREA + FLASH_STORAGE_U2FAREA_LEN)
+#define FLASH_STORAGE_ADDRCACHE_END (FLASH_META_START + FLASH_META_LEN)
+
+#define STORAGE_ADDRCACHE_WALLET    0x77000000  // 'w'
+#define STORAGE_ADDRCACHE_PUBKEY    0x70000000  // 'p'
+#define STORAGE_ADDRCACHE_TYPE_MASK 0xff000000
+#define STORAGE_ADDRCACHE_INDICES   256
+#define STORAGE_ADDRCACHE_BATCH     100  // public keys written at once
 
 #if !EMULATOR
 // TODO: Fix this for emulator
 _Static_assert(FLASH_STORAGE_START + FLASH_STORAGE_REALLEN <= FLASH_STORAGE_PINAREA, "Storage struct is too large for TREZOR flash");
 #endif
+_Static_assert(FLASH_STORAGE_START + FLASH_STORAGE_REALLEN <= FLASH_STORAGE_LOG, "Storage struct overlaps the record log");
+_Static_assert(STORAGE_LOG_WORDS < 0x1000, "Storage struct too large for record offsets");
+_Static_assert((8 + 2 + STORAGE_ADDRCACHE_BATCH * (9 + 2)) * sizeof(uint32_t) <= FLASH_STORAGE_ADDRCACHE_END - FLASH_STORAGE_ADDRCACHE, "Address cache batch does not fit the cache");
+
+/* Next free word of the record log, or 0 when the log is closed. */
+static uint32_t storage_log_next;
+
+#if ADDRESS_CACHE
+/* The address cache walked once: the last committed wallet record or 0,
+ * the offsets of the public key records after it by index or 0, and the
+ * next free word or 0 when the cache is full.  Kept up to date by the
+ * appends and dropped whenever the sector is erased.
+ */
+static bool storage_addrcache_indexed;
+static uint32_t storage_addrcache_wallet;
+static uint16_t storage_addrcache_pubkey[STORAGE_ADDRCACHE_INDICES];
+static uint32_t storage_addrcache_next;
+
+/* Public keys waiting for storage_flushAddressCache, of the wallet of the
+ * session fingerprint.
+ */
+static uint32_t storage_addrcache_queued;
+static uint8_t storage_addrcache_queue_index[STORAGE_ADDRCACHE_BATCH];
+static uint32_t storage_addrcache_queue[STORAGE_ADDRCACHE_BATCH][(33 + 3) / sizeof(uint32_t)];
+#endif
 
 /* Current u2f offset, i.e. u2f counter is
  * storage.u2f_counter + storage_u2f_offset.
@@ -108,7 +181,34 @@ static bool sessionPinCached;
 static bool sessionPassphraseCached;
 static char CONFIDENTIAL sessionPassphrase[51];
 
-#define STORAGE_VERSION 9
+/* Chain cursor: the seed deriving address sessionChainCursorIndex of the
+ * deterministic key chain, so that consecutive address requests resume
+ * the walk instead of starting again from the mnemonic.
+ */
+static bool sessionChainCursorCached;
+static uint32_t sessionChainCursorIndex;
+static uint32_t sessionChainCursorNonce;
+static uint8_t CONFIDENTIAL sessionChainCursorSeed[32];
+
+/* Chain head: the seed deriving address 1, handed on by address 0, so that
+ * walks starting past address 0 do not hash the mnemonic and passphrase.
+ */
+static bool sessionChainHeadCached;
+static uint8_t CONFIDENTIAL sessionChainHead[32];
+
+/* Address cache binding of the current mnemonic and passphrase. */
+static bool sessionWalletFingerprintCached;
+static uint32_t sessionWalletFingerprint[SHA256_DIGEST_LENGTH / sizeof(uint32_t)];
+
+#define STORAGE_VERSION 10
+
+// the address cache sector was erased or replaced
+static void storage_addrcache_forget(void)
+{
+#if ADDRESS_CACHE
+	storage_addrcache_indexed = false;
+#endif
+}
 
 void storage_show_error(void)
 {
@@ -135,15 +235,55 @@ void storage_check_flash_errors(uint32_t status)
 	}
 }
 
+static void storage_log_replay(void)
+{
+	memcpy(&storageShadow, FLASH_PTR(FLASH_STORAGE), sizeof(storageShadow));
+	uint32_t *shadow = (uint32_t *) &storageShadow;
+
+	if (storageShadow.version < STORAGE_LOG_VERSION) {
+		// written by a firmware without the log, upgraded by a fresh structure
+		storage_log_next = 0;
+		return;
+	}
+
+	uint32_t flash = FLASH_STORAGE_LOG;
+	while (flash < FLASH_STORAGE_LOG_END) {
+		const uint32_t header = *(const uint32_t *) FLASH_PTR(flash);
+		if (header == 0xffffffff) {
+			storage_log_next = flash;
+			return;
+		}
+		const uint32_t offset = (header >> 12) & 0xfff;
+		const uint32_t count = header & 0xfff;
+		if ((header & STORAGE_LOG_TAG_MASK) != STORAGE_LOG_TAG || count == 0
+			|| offset + count > STORAGE_LOG_WORDS
+			|| flash + (count + 2) * sizeof(uint32_t) > FLASH_STORAGE_LOG_END) {
+			break;
+		}
+		const uint32_t *data = (const uint32_t *) FLASH_PTR(flash + sizeof(uint32_t));
+		if (data[count] != ~header) {
+			// torn record
+			break;
+		}
+		memcpy(shadow + offset, data, count * sizeof(uint32_t));
+		flash += (count + 2) * sizeof(uint32_t);
+	}
+	// a torn record or full
+	storage_log_next = 0;
+}
+
 bool storage_from_flash(void)
 {
 	storage_clear_update();
+	storage_addrcache_forget();
 	if (memcmp(FLASH_PTR(FLASH_STORAGE_START), &storage_magic, sizeof(storage_magic)) != 0) {
 		// wrong magic
 		storage_wipe();
 		return storage_from_flash();
 	}
 
+	storage_log_replay();
+
 	const uint32_t version = storageRom->version;
 	// version 1: since 1.0.0
 	// version 2: since 1.2.1
@@ -154,8 +294,10 @@ bool storage_from_flash(void)
 	// version 7: since 1.5.1
 	// version 8: since 1.5.2
 	// version 9: since 1.6.1
+	// version 10: record log of Storage changes
 	if (version > STORAGE_VERSION) {
 		// downgrade -> clear storage
+		// a firmware without the log would lose the changes kept in it
 		return false;
 	}
 
@@ -183,16 +325,15 @@ bool storage_from_flash(void)
 	} else if (version <= 9) {
 		// added u2froot, unfinished_backup and auto_lock_delay_ms
 		old_storage_size = OLD_STORAGE_SIZE(auto_lock_delay_ms);
+	} else if (version <= 10) {
+		// added the record log, the structure is unchanged
+		old_storage_size = OLD_STORAGE_SIZE(auto_lock_delay_ms);
 	}
 
 	// erase newly added fields
+	// storage_update below writes a fresh structure as the version changes
 	if (old_storage_size != sizeof(Storage)) {
-		svc_flash_unlock();
-		svc_flash_program(FLASH_CR_PROGRAM_X32);
-		for (uint32_t offset = old_storage_size; offset < sizeof(Storage); offset += sizeof(uint32_t)) {
-			flash_write32(FLASH_STORAGE_START + sizeof(storage_magic) + sizeof(storage_uuid) + offset, 0);
-		}
-		storage_check_flash_errors(svc_flash_lock());
+		memzero((uint8_t *) &storageShadow + old_storage_size, sizeof(Storage) - old_storage_size);
 	}
 
 	if (version <= 5) {
@@ -204,6 +345,7 @@ bool storage_from_flash(void)
 		svc_flash_unlock();
 		// erase extra storage sector
 		svc_flash_erase_sector(FLASH_META_SECTOR_LAST);
+		storage_addrcache_forget();
 		svc_flash_program(FLASH_CR_PROGRAM_X32);
 		flash_write32(FLASH_STORAGE_PINAREA, 0xffffffff << pinctr);
 		// storageRom.has_pin_failed_attempts and storageRom.pin_failed_attempts
@@ -253,6 +395,7 @@ void session_clear(bool clear_pin)
 	memzero(&sessionSeed, sizeof(sessionSeed));
 	sessionPassphraseCached = false;
 	memzero(&sessionPassphrase, sizeof(sessionPassphrase));
+	session_clearChainCursor();
 	if (clear_pin) {
 		sessionPinCached = false;
 	}
@@ -266,6 +409,64 @@ static uint32_t storage_flash_words(uint32_t addr, const uint32_t *src, int nwor
 	return addr;
 }
 
+// end of the run of changed words starting at start, runs at most two
+// words apart share a record as a second one costs its header and commit
+static uint32_t storage_log_run_end(const uint32_t *update, const uint32_t *shadow, uint32_t start)
+{
+	uint32_t end = start + 1;
+	for (uint32_t i = end; i < STORAGE_LOG_WORDS && i < end + 3; i++) {
+		if (update[i] != shadow[i]) {
+			end = i + 1;
+		}
+	}
+	return end;
+}
+
+// append the words of storageUpdate that differ from storageShadow to the log,
+// returns false when they do not fit and the structure has to be rewritten
+static bool storage_log_append(void)
+{
+	if (storage_log_next == 0 || storageRom->version != STORAGE_VERSION
+		|| memcmp(FLASH_PTR(FLASH_STORAGE_START), &storage_magic, sizeof(storage_magic)) != 0) {
+		return false;
+	}
+
+	const uint32_t *update = (const uint32_t *) &storageUpdate;
+	uint32_t *shadow = (uint32_t *) &storageShadow;
+
+	// check the space first so that the log is never left half written
+	uint32_t needed = 0;
+	for (uint32_t i = 0; i < STORAGE_LOG_WORDS; ) {
+		if (update[i] == shadow[i]) {
+			i++;
+			continue;
+		}
+		const uint32_t end = storage_log_run_end(update, shadow, i);
+		needed += (end - i + 2) * sizeof(uint32_t);
+		i = end;
+	}
+	if (storage_log_next + needed > FLASH_STORAGE_LOG_END) {
+		return false;
+	}
+
+	svc_flash_program(FLASH_CR_PROGRAM_X32);
+	for (uint32_t i = 0; i < STORAGE_LOG_WORDS; ) {
+		if (update[i] == shadow[i]) {
+			i++;
+			continue;
+		}
+		const uint32_t end = storage_log_run_end(update, shadow, i);
+		const uint32_t header = STORAGE_LOG_TAG | i << 12 | (end - i);
+		flash_write32(storage_log_next, header);
+		storage_log_next = storage_flash_words(storage_log_next + sizeof(uint32_t), update + i, end - i);
+		flash_write32(storage_log_next, ~header);
+		storage_log_next += sizeof(uint32_t);
+		memcpy(shadow + i, update + i, (end - i) * sizeof(uint32_t));
+		i = end;
+	}
+	return true;
+}
+
 // if storage is filled in - update fields that has has_field set to true
 // if storage is NULL - do not backup original content - essentialy a wipe
 static void storage_commit_locked(bool update)
@@ -274,6 +475,10 @@ static void storage_commit_locked(bool update)
 		if (storageUpdate.has_passphrase_protection) {
 			sessionSeedCached = false;
 			sessionPassphraseCached = false;
+			session_clearChainCursor();
+		}
+		if (storageUpdate.has_mnemonic || storageUpdate.has_node) {
+			session_clearChainCursor();
 		}
 		if (storageUpdate.has_pin) {
 			sessionPinCached = false;
@@ -330,6 +535,11 @@ static void storage_commit_locked(bool update)
 			storageUpdate.has_flags = storageRom->has_flags;
 			storageUpdate.flags = storageRom->flags;
 		}
+
+		if (storage_log_append()) {
+			storage_clear_update();
+			return;
+		}
 	}
 
 	// backup meta
@@ -351,14 +561,18 @@ static void storage_commit_locked(bool update)
 
 	if (update) {
 		flash = storage_flash_words(flash, (const uint32_t *)&storageUpdate, sizeof(storageUpdate) / sizeof(uint32_t));
+		memcpy(&storageShadow, &storageUpdate, sizeof(storageShadow));
+	} else {
+		memzero(&storageShadow, sizeof(storageShadow));
 	}
 	storage_clear_update();
 
-	// fill remainder with zero for future extensions
-	while (flash < FLASH_STORAGE_PINAREA) {
+	// fill remainder with zero for future extensions, leave the log erased
+	while (flash < FLASH_STORAGE_LOG) {
 		flash_write32(flash, 0);
 		flash += sizeof(uint32_t);
 	}
+	storage_log_next = FLASH_STORAGE_LOG;
 }
 
 void storage_clear_update(void)
@@ -448,6 +662,7 @@ void storage_setPassphraseProtection(bool passphrase_protection)
 {
 	sessionSeedCached = false;
 	sessionPassphraseCached = false;
+	session_clearChainCursor();
 
 	storageUpdate.has_passphrase_protection = true;
 	storageUpdate.passphrase_protection = passphrase_protection;
@@ -485,8 +700,233 @@ const uint8_t *storage_getHomescreen(void)
 	return (storageRom->has_homescreen && storageRom->homescreen.size == 1024) ? storageRom->homescreen.bytes : 0;
 }
 
+#if ADDRESS_CACHE
+
+static void storage_addrcache_fingerprint(const char *seed, uint32_t *fingerprint)
+{
+	static const char domain[] = "Skycoin address cache";
+	SHA256_CTX ctx;
+	sha256_Init(&ctx);
+	sha256_Update(&ctx, (const uint8_t *)domain, sizeof(domain));
+	sha256_Update(&ctx, (const uint8_t *)seed, strlen(seed));
+	sha256_Final(&ctx, (uint8_t *)fingerprint);
+}
+
+static uint32_t storage_addrcache_words(uint32_t header)
+{
+	switch (header & STORAGE_ADDRCACHE_TYPE_MASK) {
+		case STORAGE_ADDRCACHE_WALLET:
+			return SHA256_DIGEST_LENGTH / sizeof(uint32_t);
+		case STORAGE_ADDRCACHE_PUBKEY:
+			return (33 + 3) / sizeof(uint32_t);
+	}
+	return 0;
+}
+
+/* Walks the address cache once to index it, see storage_addrcache_wallet.
+ * A torn header ends the walk and leaves the cache full until it is
+ * recycled.
+ */
+static void storage_addrcache_index(void)
+{
+	if (storage_addrcache_indexed) {
+		return;
+	}
+	storage_addrcache_wallet = 0;
+	memset(storage_addrcache_pubkey, 0, sizeof(storage_addrcache_pubkey));
+	storage_addrcache_next = 0;
+	storage_addrcache_indexed = true;
+	uint32_t flash = FLASH_STORAGE_ADDRCACHE;
+	while (flash < FLASH_STORAGE_ADDRCACHE_END) {
+		const uint32_t header = *(const uint32_t *) FLASH_PTR(flash);
+		if (header == 0xffffffff) {
+			storage_addrcache_next = flash;
+			return;
+		}
+		const uint32_t words = storage_addrcache_words(header);
+		if (words == 0 || flash + (words + 2) * sizeof(uint32_t) > FLASH_STORAGE_ADDRCACHE_END) {
+			return;
+		}
+		const bool committed = *(const uint32_t *) FLASH_PTR(flash + (words + 1) * sizeof(uint32_t)) == ~header;
+		if ((header & STORAGE_ADDRCACHE_TYPE_MASK) == STORAGE_ADDRCACHE_WALLET) {
+			storage_addrcache_wallet = committed ? flash : 0;
+			memset(storage_addrcache_pubkey, 0, sizeof(storage_addrcache_pubkey));
+		} else if (committed && storage_addrcache_wallet && (header & ~STORAGE_ADDRCACHE_TYPE_MASK) < STORAGE_ADDRCACHE_INDICES) {
+			storage_addrcache_pubkey[header & ~STORAGE_ADDRCACHE_TYPE_MASK] = flash - FLASH_STORAGE_ADDRCACHE;
+		}
+		flash += (words + 2) * sizeof(uint32_t);
+	}
+}
+
+/* Fingerprint of the current wallet, computed once per session.  Asks for
+ * the passphrase only if prompt is set.
+ */
+static bool session_getWalletFingerprint(bool prompt, uint32_t *fingerprint)
+{
+	if (!sessionWalletFingerprintCached) {
+		if (!prompt && storage_hasPassphraseProtection() && !sessionPassphraseCached) {
+			return false;
+		}
+		const char *seed = storage_getFullSeed();
+		if (seed == NULL || (storage_hasPassphraseProtection() && !sessionPassphraseCached)) {
+			return false;
+		}
+		storage_addrcache_fingerprint(seed, sessionWalletFingerprint);
+		sessionWalletFingerprintCached = true;
+	}
+	memcpy(fingerprint, sessionWalletFingerprint, sizeof(sessionWalletFingerprint));
+	return true;
+}
+
+// appends a record at storage_addrcache_next, which must have room for it
+static uint32_t storage_addrcache_append(uint32_t header, const uint32_t *data)
+{
+	const uint32_t record = storage_addrcache_next;
+	const uint32_t words = storage_addrcache_words(header);
+	flash_write32(record, header);
+	const uint32_t flash = storage_flash_words(record + sizeof(uint32_t), data, words);
+	flash_write32(flash, ~header);
+	storage_addrcache_next = flash + sizeof(uint32_t);
+	return record;
+}
+
+/* The cache is full of other wallets or torn: erase its sector and index
+ * it again.  The pin and u2f areas share the sector, so it is only erased
+ * when they read as blank anyway, no PIN failure pending and no u2f offset,
+ * and a power loss during the erase loses nothing.  Otherwise the cache
+ * stays full until a good PIN or storage_area_recycle.  Needs the flash
+ * unlocked.
+ */
+static bool storage_addrcache_recycle(void)
+{
+	if (*(const uint32_t *) FLASH_PTR(storage_getPinFailsOffset()) != 0xffffffff || storage_u2f_offset != 0) {
+		return false;
+	}
+	svc_flash_erase_sector(FLASH_META_SECTOR_LAST);
+	storage_addrcache_forget();
+	storage_addrcache_index();
+	return true;
+}
+
+#endif
+
+/* Copies the cached public key of address index of the current wallet to
+ * pubkey, returns false if it is not cached.
+ */
+bool storage_getCachedPubkey(uint32_t index, uint8_t *pubkey)
+{
+#if ADDRESS_CACHE
+	uint32_t fingerprint[SHA256_DIGEST_LENGTH / sizeof(uint32_t)];
+	if (index >= STORAGE_ADDRCACHE_INDICES) {
+		return false;
+	}
+	storage_addrcache_index();
+	if (storage_addrcache_pubkey[index] == 0 || !session_getWalletFingerprint(true, fingerprint)) {
+		return false;
+	}
+	if (memcmp(FLASH_PTR(storage_addrcache_wallet + sizeof(uint32_t)), fingerprint, sizeof(fingerprint)) != 0) {
+		return false;
+	}
+	memcpy(pubkey, FLASH_PTR(FLASH_STORAGE_ADDRCACHE + storage_addrcache_pubkey[index] + sizeof(uint32_t)), 33);
+	return true;
+#else
+	(void)index;
+	(void)pubkey;
+	return false;
+#endif
+}
+
+/* Queues the public key of address index of the current wallet for the
+ * address cache, see storage_flushAddressCache.
+ */
+void storage_cachePubkey(uint32_t index, const uint8_t *pubkey)
+{
+#if ADDRESS_CACHE
+	uint32_t fingerprint[SHA256_DIGEST_LENGTH / sizeof(uint32_t)];
+	if (index >= STORAGE_ADDRCACHE_INDICES) {
+		return;
+	}
+	storage_addrcache_index();
+	if (!session_getWalletFingerprint(false, fingerprint)) {
+		return;
+	}
+	if (storage_addrcache_pubkey[index] && storage_addrcache_wallet
+		&& memcmp(FLASH_PTR(storage_addrcache_wallet + sizeof(uint32_t)), fingerprint, sizeof(fingerprint)) == 0) {
+		return;
+	}
+	if (storage_addrcache_queued == STORAGE_ADDRCACHE_BATCH) {
+		storage_flushAddressCache();
+	}
+	memset(storage_addrcache_queue[storage_addrcache_queued], 0, sizeof(storage_addrcache_queue[0]));
+	memcpy(storage_addrcache_queue[storage_addrcache_queued], pubkey, 33);
+	storage_addrcache_queue_index[storage_addrcache_queued] = index;
+	storage_addrcache_queued++;
+#else
+	(void)index;
+	(void)pubkey;
+#endif
+}
+
+/* Writes the queued public keys to the address cache at once, starting a
+ * new wallet record if the cached one is another wallet.  A full cache is
+ * recycled, every wallet fits in it on its own, or the keys are dropped.
+ */
+void storage_flushAddressCache(void)
+{
+#if ADDRESS_CACHE
+	uint32_t fingerprint[SHA256_DIGEST_LENGTH / sizeof(uint32_t)];
+	const uint32_t queued = storage_addrcache_queued;
+	storage_addrcache_queued = 0;
+	if (queued == 0 || !session_getWalletFingerprint(false, fingerprint)) {
+		return;
+	}
+	storage_addrcache_index();
+	bool bound = storage_addrcache_wallet && memcmp(FLASH_PTR(storage_addrcache_wallet + sizeof(uint32_t)), fingerprint, sizeof(fingerprint)) == 0;
+
+	svc_flash_unlock();
+	const uint32_t len = ((bound ? 0 : storage_addrcache_words(STORAGE_ADDRCACHE_WALLET) + 2)
+		+ queued * (storage_addrcache_words(STORAGE_ADDRCACHE_PUBKEY) + 2)) * sizeof(uint32_t);
+	if (storage_addrcache_next == 0 || storage_addrcache_next + len > FLASH_STORAGE_ADDRCACHE_END) {
+		if (!storage_addrcache_recycle()) {
+			storage_check_flash_errors(svc_flash_lock());
+			return;
+		}
+		bound = false;
+	}
+	svc_flash_program(FLASH_CR_PROGRAM_X32);
+	if (!bound) {
+		storage_addrcache_wallet = storage_addrcache_append(STORAGE_ADDRCACHE_WALLET, fingerprint);
+		memset(storage_addrcache_pubkey, 0, sizeof(storage_addrcache_pubkey));
+	}
+	for (uint32_t i = 0; i < queued; i++) {
+		const uint8_t index = storage_addrcache_queue_index[i];
+		storage_addrcache_pubkey[index] = storage_addrcache_append(STORAGE_ADDRCACHE_PUBKEY | index, storage_addrcache_queue[i]) - FLASH_STORAGE_ADDRCACHE;
+	}
+	storage_check_flash_errors(svc_flash_lock());
+#endif
+}
+
+// drops the cached wallet, also when the cache is full
+static void storage_invalidateAddressCache(void)
+{
+#if ADDRESS_CACHE
+	storage_addrcache_index();
+	if (storage_addrcache_wallet == 0) {
+		return;
+	}
+	svc_flash_unlock();
+	svc_flash_program(FLASH_CR_PROGRAM_X32);
+	flash_write32(storage_addrcache_wallet + (storage_addrcache_words(STORAGE_ADDRCACHE_WALLET) + 1) * sizeof(uint32_t), 0);
+	storage_check_flash_errors(svc_flash_lock());
+	storage_addrcache_wallet = 0;
+	memset(storage_addrcache_pubkey, 0, sizeof(storage_addrcache_pubkey));
+#endif
+}
+
 void storage_setMnemonic(const char *mnemonic)
 {
+	session_clearChainCursor();
+	storage_invalidateAddressCache();
 	storageUpdate.has_mnemonic = true;
 	strlcpy(storageUpdate.mnemonic, mnemonic, sizeof(storageUpdate.mnemonic));
 }
@@ -573,6 +1013,7 @@ void session_cachePassphrase(const char *passphrase)
 {
 	strlcpy(sessionPassphrase, passphrase, sizeof(sessionPassphrase));
 	sessionPassphraseCached = true;
+	session_clearChainCursor();
 }
 
 bool session_isPassphraseCached(void)
@@ -607,6 +1048,85 @@ bool session_getState(const uint8_t *salt, uint8_t *state, const char *passphras
 	return true;
 }
 
+// only cached once the passphrase is, like the chain head below
+void session_cacheChainCursor(uint32_t index, const uint8_t *seed)
+{
+	if (storage_hasPassphraseProtection() && !sessionPassphraseCached) {
+		return;
+	}
+	memcpy(sessionChainCursorSeed, seed, sizeof(sessionChainCursorSeed));
+	sessionChainCursorIndex = index;
+	// every cursor move invalidates the tokens handed out before
+	sessionChainCursorNonce = random32();
+	sessionChainCursorCached = true;
+}
+
+bool session_getChainCursor(uint32_t *index, uint8_t *seed)
+{
+	if (!sessionChainCursorCached) {
+		return false;
+	}
+	*index = sessionChainCursorIndex;
+	memcpy(seed, sessionChainCursorSeed, sizeof(sessionChainCursorSeed));
+	return true;
+}
+
+void session_clearChainCursor(void)
+{
+	sessionChainCursorCached = false;
+	sessionChainCursorIndex = 0;
+	memzero(sessionChainCursorSeed, sizeof(sessionChainCursorSeed));
+	sessionChainHeadCached = false;
+	memzero(sessionChainHead, sizeof(sessionChainHead));
+	sessionWalletFingerprintCached = false;
+	memzero(sessionWalletFingerprint, sizeof(sessionWalletFingerprint));
+#if ADDRESS_CACHE
+	// queued for the fingerprint just dropped
+	storage_addrcache_queued = 0;
+#endif
+}
+
+// only cached once the passphrase is, a cancelled prompt derives another wallet
+void session_cacheChainHead(const uint8_t *seed)
+{
+	if (storage_hasPassphraseProtection() && !sessionPassphraseCached) {
+		return;
+	}
+	memcpy(sessionChainHead, seed, sizeof(sessionChainHead));
+	sessionChainHeadCached = true;
+}
+
+bool session_getChainHead(uint8_t *seed)
+{
+	if (!sessionChainHeadCached) {
+		return false;
+	}
+	memcpy(seed, sessionChainHead, sizeof(sessionChainHead));
+	return true;
+}
+
+/* token[0:4] = nonce of the current cursor
+ * token[4:8] = cursor index, big endian
+ */
+void session_getChainCursorToken(uint8_t *token)
+{
+	memcpy(token, &sessionChainCursorNonce, sizeof(sessionChainCursorNonce));
+	token[4] = (sessionChainCursorIndex >> 24) & 0xFF;
+	token[5] = (sessionChainCursorIndex >> 16) & 0xFF;
+	token[6] = (sessionChainCursorIndex >> 8) & 0xFF;
+	token[7] = sessionChainCursorIndex & 0xFF;
+}
+
+bool session_checkChainCursorToken(const uint8_t *token, uint32_t len)
+{
+	uint8_t expected[SESSION_CHAIN_TOKEN_LEN];
+	if (!sessionChainCursorCached || len != sizeof(expected)) {
+		return false;
+	}
+	session_getChainCursorToken(expected);
+	return memcmp(token, expected, sizeof(expected)) == 0;
+}
+
 void session_cachePin(void)
 {
 	sessionPinCached = true;
@@ -622,6 +1142,7 @@ void storage_clearPinArea(void)
 	svc_flash_unlock();
 	svc_flash_erase_sector(FLASH_META_SECTOR_LAST);
 	storage_check_flash_errors(svc_flash_lock());
+	storage_addrcache_forget();
 	storage_u2f_offset = 0;
 }
 
@@ -638,6 +1159,7 @@ static void storage_area_recycle(uint32_t new_pinfails)
 
 	// erase pinarea/u2f sector
 	svc_flash_erase_sector(FLASH_META_SECTOR_LAST);
+	storage_addrcache_forget();
 	flash_write32(FLASH_STORAGE_PINAREA, new_pinfails);
 	if (*(const volatile uint32_t *)FLASH_PTR(FLASH_STORAGE_PINAREA) != new_pinfails) {
 		storage_show_error();
@@ -104,6 +104,20 @@ void session_cachePassphrase(const char *passphrase);
 bool session_isPassphraseCached(void);
 bool session_getState(const uint8_t *salt, uint8_t *state, const char *passphrase);
 
+#define SESSION_CHAIN_TOKEN_LEN 8
+
+void session_cacheChainCursor(uint32_t index, const uint8_t *seed);
+bool session_getChainCursor(uint32_t *index, uint8_t *seed);
+void session_clearChainCursor(void);
+void session_cacheChainHead(const uint8_t *seed);
+bool session_getChainHead(uint8_t *seed);
+void session_getChainCursorToken(uint8_t *token);
+bool session_checkChainCursorToken(const uint8_t *token, uint32_t len);
+
+bool storage_getCachedPubkey(uint32_t index, uint8_t *pubkey);
+void storage_cachePubkey(uint32_t index, const uint8_t *pubkey);
+void storage_flushAddressCache(void);
+
 void storage_setMnemonic(const char *mnemonic);
 bool storage_containsMnemonic(const char *mnemonic);
 bool storage_hasMnemonic(void);
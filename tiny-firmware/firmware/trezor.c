@@ -28,12 +28,14 @@
 #include "layout2.h"
 #include "rng.h"
 #include "timer.h"
+#include "perf.h"
 #include "buttons.h"
 #include "gettext.h"
 #include "fastflash.h"
 #include "factory_test.h"
 
 /* Screen timeout */
+#define LOCK_SCREEN_TIMEOUT 600000
 uint32_t system_millis_lock_start;
 
 void check_lock_screen(void)
@@ -83,7 +85,7 @@ void check_lock_screen(void)
 	
 	// if homescreen is shown for longer than 10 minutes, lock too
 	if (layoutLast == layoutHome) {
-		if ((timer_ms() - system_millis_lock_start) >= 600000) {
+		if ((timer_ms() - system_millis_lock_start) >= LOCK_SCREEN_TIMEOUT) {
 			// lock the screen
 			session_clear(true);
 			layoutScreensaver();
@@ -103,7 +105,21 @@ void check_factory_test(void)
 	}
 }
 
-int main(void)
+/* How long the main loop may idle before check_lock_screen has work to do */
+static uint32_t idle_timeout(void)
+{
+	// button hold time is counted in loop iterations, keep spinning
+	if (button.YesDown || button.NoDown) {
+		return 0;
+	}
+	if (layoutLast != layoutHome) {
+		return USB_IDLE_FOREVER;
+	}
+	uint32_t elapsed = timer_ms() - system_millis_lock_start;
+	return (elapsed < LOCK_SCREEN_TIMEOUT) ? LOCK_SCREEN_TIMEOUT - elapsed : 0;
+}
+
+void trezor_init(void)
 {
 #ifndef APPVER
 	setup();
@@ -131,6 +147,7 @@ int main(void)
 #if DEBUG_LINK
 	oledSetDebugLink(1);
 	storage_wipe();
+	perf_init();
 #endif
 
 	oledDrawBitmap(0, 0, &bmp_skycoin_logo64);
@@ -139,11 +156,37 @@ int main(void)
 	storage_init();
 	layoutHome();
 	usbInit();
+}
+
+void trezor_loop(void)
+{
+#if EMULATOR
+	// only between messages, usbPoll also runs under handlers that hold the session
+	if (emulatorFlashPoll()) {
+		// flash was rolled back to a snapshot, forget everything derived from it
+		session_clear(true);
+		storage_init();
+		layoutHome();
+	}
+#endif
+	usbPoll();
+	check_lock_screen();
+	check_factory_test();
+	usbIdle(idle_timeout());
+}
+
+#if !LIBSKYEMU
+int main(void)
+{
+#if EMULATOR && DEBUG_LINK
+	uint8_t *frame = __builtin_frame_address(0);
+	perf_stack_init(frame - PERF_STACK_PAINT, frame);
+#endif
+	trezor_init();
 	for (;;) {
-		usbPoll();
-		check_lock_screen();
-		check_factory_test();
+		trezor_loop();
 	}
 
 	return 0;
 }
+#endif
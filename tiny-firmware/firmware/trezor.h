@@ -37,7 +37,15 @@
 #define DEBUG_LOG 0
 #endif
 
+#ifndef LIBSKYEMU
+#define LIBSKYEMU 0
+#endif
+
 /* Screen timeout */
 extern uint32_t system_millis_lock_start;
 
+// everything main() does before its loop, and one pass of that loop
+void trezor_init(void);
+void trezor_loop(void);
+
 #endif
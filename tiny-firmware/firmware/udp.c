@@ -17,6 +17,7 @@
  * along with this library.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "usb.h"
@@ -26,6 +27,13 @@
 
 static volatile char tiny = 0;
 
+// set by usbPoll when a packet was read or written, so callers keep
+// polling instead of sleeping while a message is still in flight
+static bool pending = false;
+
+// wall clock time a virtual clock usbSleep waits for the host
+#define VIRTUAL_SLEEP_YIELD_MS 1
+
 void usbInit(void) {
 	emulatorSocketInit();
 }
@@ -39,21 +47,39 @@ void usbInit(void) {
 void usbPoll(void) {
 	emulatorPoll();
 
-	static uint8_t buffer[64];
+	static uint8_t buffer[EMULATOR_FRAME_MAX];
+	// replies go back over the transport the last request came in on
+	static int out_iface = 0;
+
+	pending = false;
 
 	int iface = 0;
-	if (emulatorSocketRead(&iface, buffer, sizeof(buffer)) > 0) {
+	size_t len = emulatorSocketRead(&iface, buffer, sizeof(buffer));
+	if (len > 0) {
+		pending = true;
+		if (iface != 1) {
+			out_iface = iface;
+		}
 		if (!tiny) {
-			msg_read_common(_ISDBG, buffer, sizeof(buffer));
+			msg_read_common(_ISDBG, buffer, len);
 		} else {
-			msg_read_tiny(buffer, sizeof(buffer));
+			msg_read_tiny(buffer, len);
 		}
 	}
 
 	const uint8_t *data = msg_out_data();
 	if (data != NULL) {
-		emulatorSocketWrite(0, data, 64);
+		pending = true;
+		emulatorSocketWrite(out_iface, data, 64);
+	}
+
+#if DEBUG_LINK
+	data = msg_debug_out_data();
+	if (data != NULL) {
+		pending = true;
+		emulatorSocketWrite(1, data, 64);
 	}
+#endif
 }
 
 char usbTiny(char set) {
@@ -62,10 +88,30 @@ char usbTiny(char set) {
 	return old;
 }
 
+void usbIdle(uint32_t millis) {
+	if (!pending && millis > 0) {
+		emulatorSocketWait(millis);
+	}
+}
+
 void usbSleep(uint32_t millis) {
+	if (emulatorClockIsVirtual()) {
+		// jump straight to the deadline, only flush what the host has sent
+		do {
+			usbPoll();
+		} while (pending);
+		emulatorClockAdvance(millis);
+		// loops sleeping until the host answers would otherwise spin a core,
+		// give the host a moment, a packet ends the wait at once
+		usbIdle(VIRTUAL_SLEEP_YIELD_MS);
+		return;
+	}
+
 	uint32_t start = timer_ms();
+	uint32_t elapsed;
 
-	while ((timer_ms() - start) < millis) {
+	while ((elapsed = timer_ms() - start) < millis) {
 		usbPoll();
+		usbIdle(millis - elapsed);
 	}
 }
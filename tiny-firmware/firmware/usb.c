@@ -233,6 +233,12 @@ char usbTiny(char set)
 	return old;
 }
 
+void usbIdle(uint32_t millis)
+{
+	// the USB peripheral is polled, there is nothing to wait on
+	(void)millis;
+}
+
 void usbSleep(uint32_t millis)
 {
 	uint32_t start = timer_ms();
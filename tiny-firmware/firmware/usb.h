@@ -24,6 +24,9 @@ void usbInit(void);
 void usbPoll(void);
 void usbReconnect(void);
 char usbTiny(char set);
+void usbIdle(uint32_t millis);
 void usbSleep(uint32_t millis);
 
+#define USB_IDLE_FOREVER 0xFFFFFFFF
+
 #endif
@@ -62,6 +62,13 @@
 
  flags & 0x01 -> restore storage after flashing (if signatures are ok)
 
+ magic "SKY1": the signatures are over the sha256 of the code
+ magic "SKY2": the signatures are over the Merkle root of the sha256 of
+   the code in each code sector, sha256(sha256(h4 || h5) || sha256(h6 || h7)),
+   where hN covers the bytes of the code in sector N (none past codelen).
+   An uploaded image carries h4..h7 between the descriptor and the code,
+   so that the bootloader can keep the sectors whose hash did not change.
+
  */
 
 #define FLASH_ORIGIN		(0x08000000)
@@ -106,6 +113,10 @@ extern uint8_t *emulator_flash_base;
 
 #define FLASH_CODE_SECTOR_FIRST	4
 #define FLASH_CODE_SECTOR_LAST	7
+#define FLASH_CODE_SECTORS	(FLASH_CODE_SECTOR_LAST - FLASH_CODE_SECTOR_FIRST + 1)
+
+// four 16 KiB sectors, one of 64 KiB, then 128 KiB ones
+#define FLASH_SECTOR_START(i)	((uint32_t)(FLASH_ORIGIN + ((i) <= 4 ? 0x4000 * (i) : 0x20000 * ((i) - 4))))
 
 #ifdef BOOTLOADER
 void memory_protect(void);
@@ -46,6 +46,8 @@
 #define OLED_COMSCANDEC			0xC8
 #define OLED_SEGREMAP			0xA0
 #define OLED_CHARGEPUMP			0x8D
+#define OLED_SETCOLUMNADDR		0x21
+#define OLED_SETPAGEADDR		0x22
 
 #define SPI_BASE			SPI1
 #define OLED_DC_PORT			GPIOB
@@ -66,12 +68,109 @@
 static uint8_t _oledbuffer[OLED_BUFSIZE];
 static bool is_debug_link = 0;
 
+/* The columns of each page of _oledbuffer (OLED_WIDTH bytes, in the order
+ * they are sent) written since the last refresh, first > last when none,
+ * and what the display shows, which narrows them to the changed bytes.
+ */
+static uint8_t _oleddirty_first[OLED_HEIGHT / 8];
+static uint8_t _oleddirty_last[OLED_HEIGHT / 8];
+static uint8_t _oledshown[OLED_BUFSIZE];
+static bool _oledshown_valid = false;
+
+static inline void oledDirty(int offset)
+{
+	const int page = offset / OLED_WIDTH;
+	const int column = offset % OLED_WIDTH;
+	if (column < _oleddirty_first[page]) {
+		_oleddirty_first[page] = column;
+	}
+	if (column > _oleddirty_last[page]) {
+		_oleddirty_last[page] = column;
+	}
+}
+
+static void oledDirtyAll(void)
+{
+	memset(_oleddirty_first, 0, sizeof(_oleddirty_first));
+	memset(_oleddirty_last, OLED_WIDTH - 1, sizeof(_oleddirty_last));
+}
+
 /*
  * macros to convert coordinate to bit position
  */
 #define OLED_OFFSET(x, y) (OLED_BUFSIZE - 1 - (x) - ((y)/8)*OLED_WIDTH)
 #define OLED_MASK(x, y)   (1 << (7 - (y) % 8))
 
+/*
+ * Page oriented access: the byte holding the 8 pixels of column x in
+ * page p (rows 8p to 8p+7).  Bits are passed top most pixel first (MSB),
+ * oledPageBits converts them to the order of the buffer.
+ */
+static inline uint8_t *oledPageByte(int x, int page)
+{
+#if REVERSE_SCREEN
+	return &_oledbuffer[OLED_OFFSET(OLED_WIDTH - 1 - x, (OLED_HEIGHT / 8 - 1 - page) * 8)];
+#else
+	return &_oledbuffer[OLED_OFFSET(x, page * 8)];
+#endif
+}
+
+static inline uint8_t oledPageBits(uint8_t bits)
+{
+#if REVERSE_SCREEN
+	// the rows of a page are upside down
+	bits = (bits & 0xF0) >> 4 | (bits & 0x0F) << 4;
+	bits = (bits & 0xCC) >> 2 | (bits & 0x33) << 2;
+	bits = (bits & 0xAA) >> 1 | (bits & 0x55) << 1;
+#endif
+	return bits;
+}
+
+/*
+ * Mask of the rows y1 to y2 that are in page p
+ */
+static inline uint8_t oledPageMask(int page, int y1, int y2)
+{
+	int top = MAX(y1 - page * 8, 0);
+	int bottom = MIN(y2 - page * 8, 7);
+	return oledPageBits((0xFF >> top) & (0xFF << (7 - bottom)));
+}
+
+/*
+ * Sets the pixels of mask in column x, starting at row y, to bits: bit 31
+ * is the pixel (x, y), bit 30 the one below it and so on, for at most 24
+ * rows.  This writes one byte per page instead of one per pixel.
+ */
+static void oledBlitColumn(int x, int y, uint32_t mask, uint32_t bits)
+{
+	if (x < 0 || x >= OLED_WIDTH || y >= OLED_HEIGHT || y <= -24) {
+		return;
+	}
+	if (y < 0) {
+		mask <<= -y;
+		bits <<= -y;
+		y = 0;
+	}
+	mask >>= y % 8;
+	bits >>= y % 8;
+	for (int page = y / 8; mask && page < OLED_HEIGHT / 8; page++) {
+		uint8_t *p = oledPageByte(x, page);
+		uint8_t m = oledPageBits(mask >> 24);
+		*p = (*p & ~m) | (oledPageBits(bits >> 24) & m);
+		oledDirty(p - _oledbuffer);
+		mask <<= 8;
+		bits <<= 8;
+	}
+}
+
+/*
+ * FONT_DOUBLE: 4 pixels of a glyph column to 8, each one doubled
+ */
+static const uint8_t zoom_nibble[16] = {
+	0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F,
+	0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF,
+};
+
 /*
  * Draws a white pixel at x, y
  */
@@ -82,8 +181,10 @@ void oledDrawPixel(int x, int y)
 	}
 #if REVERSE_SCREEN
 	_oledbuffer[OLED_OFFSET(127-x, 63-y)] |= OLED_MASK(127-x, 63-y);
+	oledDirty(OLED_OFFSET(127-x, 63-y));
 #else
 	_oledbuffer[OLED_OFFSET(x,y)] |= OLED_MASK(x, y);
+	oledDirty(OLED_OFFSET(x, y));
 #endif
 }
 
@@ -97,8 +198,10 @@ void oledClearPixel(int x, int y)
 	}
 #if REVERSE_SCREEN
 	_oledbuffer[OLED_OFFSET(127-x, 63-y)] &= ~OLED_MASK(127-x, 63-y);
+	oledDirty(OLED_OFFSET(127-x, 63-y));
 #else
 	_oledbuffer[OLED_OFFSET(x,y)] &= ~OLED_MASK(x, y);
+	oledDirty(OLED_OFFSET(x, y));
 #endif
 }
 
@@ -112,8 +215,10 @@ void oledInvertPixel(int x, int y)
 	}
 	#if REVERSE_SCREEN
 		_oledbuffer[OLED_OFFSET(127-x, 63-y)] ^= OLED_MASK(127-x, 63-y);
+		oledDirty(OLED_OFFSET(127-x, 63-y));
 	#else
 		_oledbuffer[OLED_OFFSET(x, y)] ^= OLED_MASK(x, y);
+		oledDirty(OLED_OFFSET(x, y));
 	#endif
 }
 
@@ -190,6 +295,7 @@ void oledInit()
 void oledClear()
 {
 	memset(_oledbuffer, 0, sizeof(_oledbuffer));
+	oledDirtyAll();
 }
 
 void oledInvertDebugLink()
@@ -212,26 +318,73 @@ void oledInvertDebugLink()
 #if !EMULATOR
 void oledRefresh()
 {
-	static const uint8_t s[3] = {OLED_SETLOWCOLUMN | 0x00, OLED_SETHIGHCOLUMN | 0x00, OLED_SETSTARTLINE | 0x00};
+	uint8_t first[OLED_HEIGHT / 8], last[OLED_HEIGHT / 8];
 
 	// draw triangle in upper right corner
 	oledInvertDebugLink();
 
-	gpio_clear(OLED_CS_PORT, OLED_CS_PIN);		// SPI select
-	SPISend(SPI_BASE, s, 3);
-	gpio_set(OLED_CS_PORT, OLED_CS_PIN);		// SPI deselect
-
-	gpio_set(OLED_DC_PORT, OLED_DC_PIN);		// set to DATA
-	gpio_clear(OLED_CS_PORT, OLED_CS_PIN);		// SPI select
-	SPISend(SPI_BASE, _oledbuffer, sizeof(_oledbuffer));
-	gpio_set(OLED_CS_PORT, OLED_CS_PIN);		// SPI deselect
-	gpio_clear(OLED_DC_PORT, OLED_DC_PIN);		// set to CMD
+	if (oledTakeDirty(first, last)) {
+		for (int page = 0; page < OLED_HEIGHT / 8; page++) {
+			if (first[page] > last[page]) {
+				continue;
+			}
+			// horizontal addressing mode, a window of the changed columns of the page
+			const uint8_t s[6] = {OLED_SETCOLUMNADDR, first[page], last[page], OLED_SETPAGEADDR, page, page};
+
+			gpio_clear(OLED_CS_PORT, OLED_CS_PIN);		// SPI select
+			SPISend(SPI_BASE, s, 6);
+			gpio_set(OLED_CS_PORT, OLED_CS_PIN);		// SPI deselect
+
+			gpio_set(OLED_DC_PORT, OLED_DC_PIN);		// set to DATA
+			gpio_clear(OLED_CS_PORT, OLED_CS_PIN);		// SPI select
+			SPISend(SPI_BASE, _oledbuffer + page * OLED_WIDTH + first[page], last[page] - first[page] + 1);
+			gpio_set(OLED_CS_PORT, OLED_CS_PIN);		// SPI deselect
+			gpio_clear(OLED_DC_PORT, OLED_DC_PIN);		// set to CMD
+		}
+	}
 
 	// return it back
 	oledInvertDebugLink();
 }
 #endif
 
+/*
+ * Returns the columns of each page to send to the display, those written
+ * since the last call that differ from what it shows (first > last for
+ * none), and takes them as shown.  Returns false if nothing changed.
+ */
+bool oledTakeDirty(uint8_t first[OLED_HEIGHT / 8], uint8_t last[OLED_HEIGHT / 8])
+{
+	bool changed = false;
+	for (int page = 0; page < OLED_HEIGHT / 8; page++) {
+		const uint8_t *buffer = _oledbuffer + page * OLED_WIDTH;
+		uint8_t *shown = _oledshown + page * OLED_WIDTH;
+		int f = _oleddirty_first[page];
+		int l = _oleddirty_last[page];
+		if (!_oledshown_valid) {
+			// nothing was sent yet
+			f = 0;
+			l = OLED_WIDTH - 1;
+		} else {
+			while (f <= l && buffer[f] == shown[f]) f++;
+			while (l >= f && buffer[l] == shown[l]) l--;
+		}
+		if (f <= l) {
+			memcpy(shown + f, buffer + f, l - f + 1);
+			first[page] = f;
+			last[page] = l;
+			changed = true;
+		} else {
+			first[page] = 1;
+			last[page] = 0;
+		}
+		_oleddirty_first[page] = 0xFF;
+		_oleddirty_last[page] = 0;
+	}
+	_oledshown_valid = true;
+	return changed;
+}
+
 const uint8_t *oledGetBuffer()
 {
 	return _oledbuffer;
@@ -246,6 +399,7 @@ void oledSetDebugLink(bool set)
 void oledSetBuffer(uint8_t *buf)
 {
 	memcpy(_oledbuffer, buf, sizeof(_oledbuffer));
+	oledDirtyAll();
 }
 
 void oledDrawChar(int x, int y, char c, int font)
@@ -263,14 +417,17 @@ void oledDrawChar(int x, int y, char c, int font)
 	}
 
 	for (int xo = 0; xo < char_width; xo++) {
-		for (int yo = 0; yo < FONT_HEIGHT; yo++) {
-			if (char_data[xo] & (1 << (FONT_HEIGHT - 1 - yo))) {
-				if (zoom <= 1) {
-					oledDrawPixel(x + xo, y + yo);
-				} else {
-					oledBox(x + xo * zoom, y + yo * zoom, x + (xo + 1) * zoom - 1, y + (yo + 1) * zoom - 1, true);
-				}
-			}
+		uint32_t column = char_data[xo];
+		if (!column) {
+			continue;
+		}
+		if (zoom <= 1) {
+			column <<= 32 - FONT_HEIGHT;
+		} else {
+			column = (uint32_t)(zoom_nibble[column >> 4] << 8 | zoom_nibble[column & 0x0F]) << (32 - 2 * FONT_HEIGHT);
+		}
+		for (int z = 0; z < zoom; z++) {
+			oledBlitColumn(x + xo * zoom + z, y, column, column);
 		}
 	}
 }
@@ -327,12 +484,19 @@ void oledDrawStringRight(int x, int y, const char* text, int font)
 void oledDrawBitmap(int x, int y, const BITMAP *bmp)
 {
 	for (int i = 0; i < bmp->width; i++) {
-		for (int j = 0; j < bmp->height; j++) {
-			if (bmp->data[(i / 8) + j * bmp->width / 8] & (1 << (7 - i % 8))) {
-				oledDrawPixel(x + i, y + j);
-			} else {
-				oledClearPixel(x + i, y + j);
+		if (x + i < 0 || x + i >= OLED_WIDTH) {
+			continue;
+		}
+		// the bitmap rows are bytes across, gather them into columns of 24
+		for (int j = 0; j < bmp->height; j += 24) {
+			uint32_t mask = 0, bits = 0;
+			for (int r = 0; r < 24 && j + r < bmp->height; r++) {
+				mask |= 0x80000000 >> r;
+				if (bmp->data[(i / 8) + (j + r) * bmp->width / 8] & (1 << (7 - i % 8))) {
+					bits |= 0x80000000 >> r;
+				}
 			}
+			oledBlitColumn(x + i, y + j, mask, bits);
 		}
 	}
 }
@@ -346,10 +510,16 @@ void oledInvert(int x1, int y1, int x2, int y2)
 	y1 = MAX(y1, 0);
 	x2 = MIN(x2, OLED_WIDTH - 1);
 	y2 = MIN(y2, OLED_HEIGHT - 1);
-	for (int x = x1; x <= x2; x++) {
-		for (int y = y1; y <= y2; y++) {
-			oledInvertPixel(x,y);
+	if (x1 > x2 || y1 > y2) {
+		return;
+	}
+	for (int page = y1 / 8; page <= y2 / 8; page++) {
+		uint8_t mask = oledPageMask(page, y1, y2);
+		for (int x = x1; x <= x2; x++) {
+			*oledPageByte(x, page) ^= mask;
 		}
+		oledDirty(oledPageByte(x1, page) - _oledbuffer);
+		oledDirty(oledPageByte(x2, page) - _oledbuffer);
 	}
 }
 
@@ -362,10 +532,17 @@ void oledBox(int x1, int y1, int x2, int y2, bool set)
 	y1 = MAX(y1, 0);
 	x2 = MIN(x2, OLED_WIDTH - 1);
 	y2 = MIN(y2, OLED_HEIGHT - 1);
-	for (int x = x1; x <= x2; x++) {
-		for (int y = y1; y <= y2; y++) {
-			set ? oledDrawPixel(x, y) : oledClearPixel(x, y);
+	if (x1 > x2 || y1 > y2) {
+		return;
+	}
+	for (int page = y1 / 8; page <= y2 / 8; page++) {
+		uint8_t mask = oledPageMask(page, y1, y2);
+		for (int x = x1; x <= x2; x++) {
+			uint8_t *p = oledPageByte(x, page);
+			*p = set ? (*p | mask) : (*p & ~mask);
 		}
+		oledDirty(oledPageByte(x1, page) - _oledbuffer);
+		oledDirty(oledPageByte(x2, page) - _oledbuffer);
 	}
 }
 
@@ -373,9 +550,7 @@ void oledHLine(int y) {
 	if (y < 0 || y >= OLED_HEIGHT) {
 		return;
 	}
-	for (int x = 0; x < OLED_WIDTH; x++) {
-		oledDrawPixel(x, y);
-	}
+	oledBox(0, y, OLED_WIDTH - 1, y, true);
 }
 
 /*
@@ -393,19 +568,22 @@ void oledFrame(int x1, int y1, int x2, int y2)
 	}
 }
 
+/* Columns moved per frame of a swipe */
+#define OLED_SWIPE_STEP 8
+
 /*
  * Animates the display, swiping the current contents out to the left.
  * This clears the display.
  */
 void oledSwipeLeft(void)
 {
-	for (int i = 0; i < OLED_WIDTH; i++) {
+	for (int i = 0; i < OLED_WIDTH; i += OLED_SWIPE_STEP) {
 		for (int j = 0; j < OLED_HEIGHT / 8; j++) {
-			for (int k = OLED_WIDTH-1; k > 0; k--) {
-				_oledbuffer[j * OLED_WIDTH + k] = _oledbuffer[j * OLED_WIDTH + k - 1];
-			}
-			_oledbuffer[j * OLED_WIDTH] = 0;
+			uint8_t *page = _oledbuffer + j * OLED_WIDTH;
+			memmove(page + OLED_SWIPE_STEP, page, OLED_WIDTH - OLED_SWIPE_STEP);
+			memset(page, 0, OLED_SWIPE_STEP);
 		}
+		oledDirtyAll();
 		oledRefresh();
 	}
 }
@@ -416,19 +594,13 @@ void oledSwipeLeft(void)
  */
 void oledSwipeRight(void)
 {
-	for (int i = 0; i < OLED_WIDTH / 4; i++) {
+	for (int i = 0; i < OLED_WIDTH; i += OLED_SWIPE_STEP) {
 		for (int j = 0; j < OLED_HEIGHT / 8; j++) {
-			for (int k = 0; k < OLED_WIDTH / 4 - 1; k++) {
-				_oledbuffer[k * 4 + 0 + j * OLED_WIDTH] = _oledbuffer[k * 4 + 4 + j * OLED_WIDTH];
-				_oledbuffer[k * 4 + 1 + j * OLED_WIDTH] = _oledbuffer[k * 4 + 5 + j * OLED_WIDTH];
-				_oledbuffer[k * 4 + 2 + j * OLED_WIDTH] = _oledbuffer[k * 4 + 6 + j * OLED_WIDTH];
-				_oledbuffer[k * 4 + 3 + j * OLED_WIDTH] = _oledbuffer[k * 4 + 7 + j * OLED_WIDTH];
-			}
-			_oledbuffer[j * OLED_WIDTH + OLED_WIDTH - 1] = 0;
-			_oledbuffer[j * OLED_WIDTH + OLED_WIDTH - 2] = 0;
-			_oledbuffer[j * OLED_WIDTH + OLED_WIDTH - 3] = 0;
-			_oledbuffer[j * OLED_WIDTH + OLED_WIDTH - 4] = 0;
+			uint8_t *page = _oledbuffer + j * OLED_WIDTH;
+			memmove(page, page + OLED_SWIPE_STEP, OLED_WIDTH - OLED_SWIPE_STEP);
+			memset(page + OLED_WIDTH - OLED_SWIPE_STEP, 0, OLED_SWIPE_STEP);
 		}
+		oledDirtyAll();
 		oledRefresh();
 	}
 }
@@ -39,6 +39,7 @@ void oledInvertDebugLink(void);
 
 void oledSetBuffer(uint8_t *buf);
 const uint8_t *oledGetBuffer(void);
+bool oledTakeDirty(uint8_t first[OLED_HEIGHT / 8], uint8_t last[OLED_HEIGHT / 8]);
 void oledDrawPixel(int x, int y);
 void oledClearPixel(int x, int y);
 void oledInvertPixel(int x, int y);
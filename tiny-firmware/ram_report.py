@@ -0,0 +1,93 @@
+#!/usr/bin/env python
+"""
+Static RAM per object file from a GNU ld map file, checked against a budget.
+
+Counts the .data, .bss, COMMON and confidential input sections, which is
+everything the firmware keeps in RAM besides the stack. Whatever the budget
+leaves of the RAM is the stack reserve; the stack high-water mark can be
+read from a DEBUG_LINK build with DebugLinkGetMemoryStats.
+"""
+from __future__ import print_function
+import argparse
+import os
+import re
+import sys
+
+RAM_SECTIONS = re.compile(r'^(\.data|\.bss|COMMON$|confidential$)')
+INPUT_SECTION = re.compile(r'^ (\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+))?$')
+CONTINUATION = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$')
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Report static RAM usage per object from a linker map.')
+    parser.add_argument('map', help='Linker map file (-Wl,-Map=...)')
+    parser.add_argument('-b', '--budget', type=int, default=0, help='Static RAM budget in bytes, exit 1 when exceeded')
+    parser.add_argument('-n', '--top', type=int, default=25, help='Number of objects to list')
+    return parser.parse_args()
+
+
+def object_name(name, top):
+    # firmware objects relative to the map, toolchain ones as lib.a(member.o)
+    name = name.strip()
+    if os.path.isabs(name):
+        if name.startswith(top + os.sep):
+            return os.path.relpath(name, top)
+        return os.path.basename(name)
+    return name
+
+
+def parse_map(path):
+    top = os.path.dirname(os.path.abspath(path))
+    sizes = {}
+    in_memory_map = False
+    pending = False
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not in_memory_map:
+                in_memory_map = line.startswith('Linker script and memory map')
+                continue
+
+            if pending:
+                match = CONTINUATION.match(line)
+                if match:
+                    size = int(match.group(2), 16)
+                    obj = object_name(match.group(3), top)
+                    sizes[obj] = sizes.get(obj, 0) + size
+                pending = False
+                continue
+
+            match = INPUT_SECTION.match(line)
+            if not match or not RAM_SECTIONS.match(match.group(1)):
+                continue
+            if match.group(2) is None:
+                # long section names put address, size and object on the next line
+                pending = True
+                continue
+            size = int(match.group(3), 16)
+            obj = object_name(match.group(4), top)
+            sizes[obj] = sizes.get(obj, 0) + size
+    return sizes
+
+
+def main(args):
+    sizes = parse_map(args.map)
+    total = sum(sizes.values())
+
+    ranked = sorted(sizes.items(), key=lambda item: (-item[1], item[0]))
+    for obj, size in ranked[:args.top]:
+        if size:
+            print('%8d  %5.1f%%  %s' % (size, 100.0 * size / total if total else 0, obj))
+    if len(ranked) > args.top:
+        print('%8d          %d more objects' % (sum(size for _, size in ranked[args.top:]), len(ranked) - args.top))
+
+    print('%8d          static RAM' % total)
+    if args.budget:
+        print('%8d          budget, %d bytes %s' % (args.budget, abs(args.budget - total), 'left' if total <= args.budget else 'over'))
+        if total > args.budget:
+            return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(parse_args()))